@@ -27,7 +27,10 @@ public class HelicopterMovement : ModuleRules
 			{
 				"Core",
 				"EnhancedInput",
-				"InputCore"
+				"InputCore",
+				"MassEntity",
+				"StructUtils",
+				"ReplicationGraph"
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -40,6 +43,10 @@ public class HelicopterMovement : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"NetCore",
+				"AIModule",
+				"Chaos",
+				"PhysicsCore",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,68 @@
+#include "HelicopterAmbientFlightProcessor.h"
+#include "HelicopterAmbientFragments.h"
+#include "HelicopterFlightModel.h"
+#include "MassExecutionContext.h"
+
+UHelicopterAmbientFlightProcessor::UHelicopterAmbientFlightProcessor()
+	: EntityQuery(*this)
+{
+	bAutoRegisterWithProcessingPhases = false;
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+}
+
+void UHelicopterAmbientFlightProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FHelicopterAmbientTransformFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FHelicopterAmbientFlightFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddRequirement<FHelicopterAmbientRouteFragment>(EMassFragmentAccess::ReadWrite);
+	EntityQuery.AddConstSharedRequirement<FHelicopterAmbientParamsFragment>();
+}
+
+void UHelicopterAmbientFlightProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context)
+	{
+		const TArrayView<FHelicopterAmbientTransformFragment> Transforms = Context.GetMutableFragmentView<FHelicopterAmbientTransformFragment>();
+		const TArrayView<FHelicopterAmbientFlightFragment> Flights = Context.GetMutableFragmentView<FHelicopterAmbientFlightFragment>();
+		const TArrayView<FHelicopterAmbientRouteFragment> Routes = Context.GetMutableFragmentView<FHelicopterAmbientRouteFragment>();
+		const FHelicopterAmbientParamsFragment& AmbientParams = Context.GetConstSharedFragment<FHelicopterAmbientParamsFragment>();
+
+		const FHelicopterFlightParams FlightParams = AmbientParams.GetFlightParams();
+		const float DeltaTime = Context.GetDeltaTimeSeconds();
+
+		for (int32 Index = 0; Index < Context.GetNumEntities(); Index++)
+		{
+			FTransform& Transform = Transforms[Index].Transform;
+			FHelicopterAmbientFlightFragment& Flight = Flights[Index];
+			FHelicopterAmbientRouteFragment& Route = Routes[Index];
+
+			const FVector Location = Transform.GetLocation();
+			const FRotator Rotation = Transform.Rotator();
+
+			// Ambient traffic just wanders between random points in its area
+			FVector ToDestination = Route.Destination - Location;
+			if (ToDestination.SizeSquared() <= FMath::Square(AmbientParams.AcceptanceRadius) && AmbientParams.Area.IsValid)
+			{
+				Route.Destination = FMath::RandPointInBox(AmbientParams.Area);
+				ToDestination = Route.Destination - Location;
+			}
+
+			// Ease off as the destination gets close so the helicopter does not overshoot it
+			const float Distance = ToDestination.Size();
+			const float DesiredSpeed = FMath::Min(AmbientParams.CruiseSpeed, Distance * FlightParams.VelocityDamping * 0.25f);
+			const FVector DesiredVelocity = ToDestination.GetSafeNormal() * DesiredSpeed;
+			Flight.DesiredInput = FHelicopterFlightModel::ComputeInputForVelocity(Rotation, DesiredVelocity, FlightParams);
+
+			const float TargetYaw = FMath::RadiansToDegrees(FMath::Atan2(ToDestination.Y, ToDestination.X));
+			const float YawError = FMath::FindDeltaAngleDegrees(Rotation.Yaw, TargetYaw);
+			Flight.DesiredYawInput = FMath::Clamp(YawError * FlightParams.VelocityDamping * 0.5f / FMath::Max(FlightParams.YawSpeed, 1.0f), -1.0f, 1.0f);
+
+			// Same integration the mover component runs, ambient traffic flies in open air so no sweep is done
+			const FRotator NewRotation = FHelicopterFlightModel::Integrate(Rotation, Flight.DesiredInput, Flight.DesiredYawInput,
+				FlightParams, DeltaTime, Flight.Velocity, Flight.YawSpeed);
+
+			Transform.SetLocation(Location + Flight.Velocity * DeltaTime);
+			Transform.SetRotation(NewRotation.Quaternion());
+		}
+	});
+}
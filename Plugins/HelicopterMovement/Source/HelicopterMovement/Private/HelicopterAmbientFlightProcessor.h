@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "MassEntityQuery.h"
+#include "HelicopterAmbientFlightProcessor.generated.h"
+
+/* * * Steers and integrates every ambient helicopter with the shared flight model * * */
+// Executed explicitly by the ambient traffic subsystem rather than auto registered with the processing phases,
+// so the plugin does not depend on the Mass simulation subsystem from MassGameplay.
+UCLASS()
+class UHelicopterAmbientFlightProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UHelicopterAmbientFlightProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery EntityQuery;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "HelicopterFlightModel.h"
+#include "HelicopterAmbientFragments.generated.h"
+
+/* * * World transform of an ambient helicopter * * */
+USTRUCT()
+struct FHelicopterAmbientTransformFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FTransform Transform;
+};
+
+/* * * Flight model state, mirrors the values the mover component keeps * * */
+USTRUCT()
+struct FHelicopterAmbientFlightFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FVector Velocity = FVector::ZeroVector;
+	float YawSpeed = 0.0f;
+	FVector DesiredInput = FVector::ZeroVector;
+	float DesiredYawInput = 0.0f;
+};
+
+/* * * Where the ambient helicopter is currently flying to * * */
+USTRUCT()
+struct FHelicopterAmbientRouteFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FVector Destination = FVector::ZeroVector;
+};
+
+/* * * Tuning shared by every ambient helicopter of the same type * * */
+// Values are UPROPERTYs so the entity manager can tell different tunings apart when sharing the fragment.
+USTRUCT()
+struct FHelicopterAmbientParamsFragment : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	float MaxForwardSpeed = 1500.0f;
+
+	UPROPERTY()
+	float MaxLateralSpeed = 1000.0f;
+
+	UPROPERTY()
+	float MaxVerticalSpeed = 500.0f;
+
+	UPROPERTY()
+	float YawSpeed = 90.0f;
+
+	UPROPERTY()
+	float VelocityDamping = 0.95f;
+
+	/* Volume new destinations are picked from */
+	UPROPERTY()
+	FBox Area = FBox(ForceInit);
+
+	UPROPERTY()
+	float CruiseSpeed = 1000.0f;
+
+	UPROPERTY()
+	float AcceptanceRadius = 500.0f;
+
+	FHelicopterFlightParams GetFlightParams() const
+	{
+		FHelicopterFlightParams Params;
+		Params.MaxForwardSpeed = MaxForwardSpeed;
+		Params.MaxLateralSpeed = MaxLateralSpeed;
+		Params.MaxVerticalSpeed = MaxVerticalSpeed;
+		Params.YawSpeed = YawSpeed;
+		Params.VelocityDamping = VelocityDamping;
+		return Params;
+	}
+};
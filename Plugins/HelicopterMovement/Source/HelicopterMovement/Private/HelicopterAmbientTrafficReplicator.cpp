@@ -0,0 +1,109 @@
+#include "HelicopterAmbientTrafficReplicator.h"
+#include "HelicopterAmbientTrafficSubsystem.h"
+#include "HelicopterBasePawn.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+static UHelicopterAmbientTrafficSubsystem* GetAmbientTrafficSubsystem(const FHelicopterAmbientTrafficArray& InArraySerializer)
+{
+	const UWorld* World = InArraySerializer.Owner ? InArraySerializer.Owner->GetWorld() : nullptr;
+	return World ? World->GetSubsystem<UHelicopterAmbientTrafficSubsystem>() : nullptr;
+}
+
+void FHelicopterAmbientTrafficItem::PostReplicatedAdd(const FHelicopterAmbientTrafficArray& InArraySerializer)
+{
+	if (UHelicopterAmbientTrafficSubsystem* AmbientTraffic = GetAmbientTrafficSubsystem(InArraySerializer))
+	{
+		AmbientTraffic->AddReplicatedAmbient(*this);
+	}
+}
+
+void FHelicopterAmbientTrafficItem::PostReplicatedChange(const FHelicopterAmbientTrafficArray& InArraySerializer)
+{
+	if (UHelicopterAmbientTrafficSubsystem* AmbientTraffic = GetAmbientTrafficSubsystem(InArraySerializer))
+	{
+		AmbientTraffic->UpdateReplicatedAmbient(*this);
+	}
+}
+
+void FHelicopterAmbientTrafficItem::PreReplicatedRemove(const FHelicopterAmbientTrafficArray& InArraySerializer)
+{
+	if (UHelicopterAmbientTrafficSubsystem* AmbientTraffic = GetAmbientTrafficSubsystem(InArraySerializer))
+	{
+		AmbientTraffic->RemoveReplicatedAmbient(AmbientId);
+	}
+}
+
+AHelicopterAmbientTrafficReplicator::AHelicopterAmbientTrafficReplicator()
+{
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+
+	// Resyncs are spread over frames by the subsystem, this only bounds how often they are flushed
+	NetUpdateFrequency = 10.0f;
+	MinNetUpdateFrequency = 2.0f;
+
+	Area = FBox(ForceInit);
+}
+
+void AHelicopterAmbientTrafficReplicator::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Traffic.Owner = this;
+}
+
+void AHelicopterAmbientTrafficReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AHelicopterAmbientTrafficReplicator, HelicopterClass);
+	DOREPLIFETIME(AHelicopterAmbientTrafficReplicator, Area);
+	DOREPLIFETIME(AHelicopterAmbientTrafficReplicator, Traffic);
+}
+
+void AHelicopterAmbientTrafficReplicator::SetTrafficSetup(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, const FBox& InArea)
+{
+	HelicopterClass = InHelicopterClass;
+	Area = InArea;
+}
+
+void AHelicopterAmbientTrafficReplicator::OnRep_TrafficSetup()
+{
+	if (!HelicopterClass || !Area.IsValid) return;
+
+	if (UHelicopterAmbientTrafficSubsystem* AmbientTraffic = GetWorld()->GetSubsystem<UHelicopterAmbientTrafficSubsystem>())
+	{
+		AmbientTraffic->SetupReplicatedTraffic(this);
+	}
+}
+
+void AHelicopterAmbientTrafficReplicator::WriteItem(FHelicopterAmbientTrafficItem& Item, const FTransform& Transform, const FVector& Velocity, const FVector& Destination)
+{
+	Item.Position = Transform.GetLocation();
+	Item.Velocity = Velocity;
+	Item.Destination = Destination;
+	Item.Yaw = FRotator::CompressAxisToShort(Transform.Rotator().Yaw);
+}
+
+void AHelicopterAmbientTrafficReplicator::AddAmbient(int32 AmbientId, const FTransform& Transform, const FVector& Velocity, const FVector& Destination)
+{
+	FHelicopterAmbientTrafficItem& Item = Traffic.Items.AddDefaulted_GetRef();
+	Item.AmbientId = AmbientId;
+	WriteItem(Item, Transform, Velocity, Destination);
+	Traffic.MarkItemDirty(Item);
+}
+
+void AHelicopterAmbientTrafficReplicator::UpdateAmbient(int32 Index, const FTransform& Transform, const FVector& Velocity, const FVector& Destination)
+{
+	FHelicopterAmbientTrafficItem& Item = Traffic.Items[Index];
+	WriteItem(Item, Transform, Velocity, Destination);
+	Traffic.MarkItemDirty(Item);
+}
+
+void AHelicopterAmbientTrafficReplicator::RemoveAmbientAtSwap(int32 Index)
+{
+	Traffic.Items.RemoveAtSwap(Index);
+	Traffic.MarkArrayDirty();
+}
@@ -0,0 +1,468 @@
+#include "HelicopterAmbientTrafficSubsystem.h"
+#include "HelicopterAmbientTrafficReplicator.h"
+#include "HelicopterMovement.h"
+#include "HelicopterBasePawn.h"
+#include "HelicopterMoverComponent.h"
+#include "HelicopterAutopilotSubsystem.h"
+#include "HelicopterAmbientFragments.h"
+#include "HelicopterAmbientFlightProcessor.h"
+#include "MassEntitySubsystem.h"
+#include "MassExecutor.h"
+#include "MassProcessingTypes.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ambient Traffic Tick"), STAT_HelicopterAmbientTick, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Ambient Traffic LOD"), STAT_HelicopterAmbientLOD, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Ambient Traffic Resync"), STAT_HelicopterAmbientResync, STATGROUP_HelicopterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ambient Helicopters"), STAT_HelicopterAmbientCount, STATGROUP_HelicopterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Promoted Ambient Helicopters"), STAT_HelicopterPromotedCount, STATGROUP_HelicopterMovement);
+
+bool UHelicopterAmbientTrafficSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHelicopterAmbientTrafficSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency<UMassEntitySubsystem>();
+	Collection.InitializeDependency<UHelicopterAutopilotSubsystem>();
+
+	FlightProcessor = NewObject<UHelicopterAmbientFlightProcessor>(this);
+	FlightProcessor->Initialize(*this);
+
+	if (UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>())
+	{
+		AmbientArchetype = EntitySubsystem->GetMutableEntityManager().CreateArchetype({
+			FHelicopterAmbientTransformFragment::StaticStruct(),
+			FHelicopterAmbientFlightFragment::StaticStruct(),
+			FHelicopterAmbientRouteFragment::StaticStruct()
+		});
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::Deinitialize()
+{
+	if (UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>())
+	{
+		EntitySubsystem->GetMutableEntityManager().BatchDestroyEntities(AmbientEntities);
+	}
+	AmbientEntities.Reset();
+	AmbientIds.Reset();
+	AmbientIndexById.Reset();
+	Promoted.Reset();
+
+	Super::Deinitialize();
+}
+
+void UHelicopterAmbientTrafficSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAmbientTick);
+
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem) return;
+
+	if (AmbientEntities.Num() > 0)
+	{
+		FMassProcessingContext ProcessingContext(EntitySubsystem->GetMutableEntityManager(), DeltaTime);
+		UE::Mass::Executor::Run(*FlightProcessor, ProcessingContext);
+	}
+
+	// Clients only fly and draw what the server sends them
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		TimeSinceLODUpdate += DeltaTime;
+		if (TimeSinceLODUpdate >= LODUpdateInterval)
+		{
+			TimeSinceLODUpdate = 0.0f;
+			UpdateLOD();
+		}
+
+		ResyncAmbient(DeltaTime);
+	}
+
+	UpdateInstances();
+
+	SET_DWORD_STAT(STAT_HelicopterAmbientCount, AmbientEntities.Num());
+	SET_DWORD_STAT(STAT_HelicopterPromotedCount, Promoted.Num());
+}
+
+bool UHelicopterAmbientTrafficSubsystem::IsTickable() const
+{
+	return AmbientEntities.Num() > 0 || Promoted.Num() > 0;
+}
+
+TStatId UHelicopterAmbientTrafficSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHelicopterAmbientTrafficSubsystem, STATGROUP_Tickables);
+}
+
+void UHelicopterAmbientTrafficSubsystem::SpawnAmbientHelicopters(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, int32 Count, FBox InArea)
+{
+	UWorld* World = GetWorld();
+	if (!InHelicopterClass || Count <= 0 || !InArea.IsValid || World->GetNetMode() == NM_Client) return;
+
+	SetupAmbientClass(InHelicopterClass, InArea);
+
+	// Standalone games have nobody to send the traffic to
+	if (!Replicator && World->GetNetMode() != NM_Standalone)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Replicator = World->SpawnActor<AHelicopterAmbientTrafficReplicator>(SpawnParams);
+	}
+	if (Replicator)
+	{
+		Replicator->SetTrafficSetup(HelicopterClass, Area);
+	}
+
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		const FVector Location = FMath::RandPointInBox(Area);
+		const FRotator Rotation(0.0f, FMath::FRandRange(-180.0f, 180.0f), 0.0f);
+		CreateAmbientEntity(NextAmbientId++, FTransform(Rotation, Location), FVector::ZeroVector, 0.0f, FMath::RandPointInBox(Area));
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::SetupAmbientClass(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, const FBox& InArea)
+{
+	UWorld* World = GetWorld();
+	HelicopterClass = InHelicopterClass;
+	Area = InArea;
+
+	// Ambient traffic flies with the tuning of the pawn it gets promoted to
+	const AHelicopterBasePawn* HelicopterDefaults = HelicopterClass->GetDefaultObject<AHelicopterBasePawn>();
+	FHelicopterAmbientParamsFragment Params;
+	if (const UHelicopterMoverComponent* MoverDefaults = HelicopterDefaults->HelicopterMover)
+	{
+		Params.MaxForwardSpeed = MoverDefaults->MaxForwardSpeed;
+		Params.MaxLateralSpeed = MoverDefaults->MaxLateralSpeed;
+		Params.MaxVerticalSpeed = MoverDefaults->MaxVerticalSpeed;
+		Params.YawSpeed = MoverDefaults->YawSpeed;
+		Params.VelocityDamping = MoverDefaults->VelocityDamping;
+		Params.CruiseSpeed = MoverDefaults->MaxForwardSpeed * 0.6f;
+	}
+	Params.Area = Area;
+
+	FMassEntityManager& EntityManager = World->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager();
+	AmbientSharedValues = FMassArchetypeSharedFragmentValues();
+	AmbientSharedValues.AddConstSharedFragment(EntityManager.GetOrCreateConstSharedFragment(Params));
+	AmbientSharedValues.Sort();
+
+	if (!Instances && World->GetNetMode() != NM_DedicatedServer)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		AActor* InstanceActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+		Instances = NewObject<UInstancedStaticMeshComponent>(InstanceActor, TEXT("AmbientHelicopterInstances"));
+		Instances->bSupportRemoveAtSwap = true;
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetStaticMesh(HelicopterDefaults->HelicopterBody ? HelicopterDefaults->HelicopterBody->GetStaticMesh() : nullptr);
+		InstanceActor->SetRootComponent(Instances);
+		Instances->RegisterComponent();
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::SetupReplicatedTraffic(const AHelicopterAmbientTrafficReplicator* InReplicator)
+{
+	SetupAmbientClass(InReplicator->GetHelicopterClass(), InReplicator->GetArea());
+
+	// Items that arrived before the class and area could not be created yet
+	for (const FHelicopterAmbientTrafficItem& Item : InReplicator->GetTraffic().Items)
+	{
+		AddReplicatedAmbient(Item);
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::AddReplicatedAmbient(const FHelicopterAmbientTrafficItem& Item)
+{
+	if (!HelicopterClass) return;
+
+	if (AmbientIndexById.Contains(Item.AmbientId))
+	{
+		UpdateReplicatedAmbient(Item);
+		return;
+	}
+
+	const FRotator Rotation(0.0f, FRotator::DecompressAxisFromShort(Item.Yaw), 0.0f);
+	CreateAmbientEntity(Item.AmbientId, FTransform(Rotation, Item.Position), Item.Velocity, 0.0f, Item.Destination);
+}
+
+void UHelicopterAmbientTrafficSubsystem::UpdateReplicatedAmbient(const FHelicopterAmbientTrafficItem& Item)
+{
+	if (!HelicopterClass) return;
+
+	const int32* AmbientIndex = AmbientIndexById.Find(Item.AmbientId);
+	if (!AmbientIndex)
+	{
+		AddReplicatedAmbient(Item);
+		return;
+	}
+
+	// Snap the local simulation to the server's, at a few metres of drift nobody sees the jump at ambient distances
+	FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager();
+	const FMassEntityHandle Entity = AmbientEntities[*AmbientIndex];
+
+	const FRotator Rotation(0.0f, FRotator::DecompressAxisFromShort(Item.Yaw), 0.0f);
+	EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(Entity).Transform = FTransform(Rotation, Item.Position);
+	EntityManager.GetFragmentDataChecked<FHelicopterAmbientFlightFragment>(Entity).Velocity = Item.Velocity;
+	EntityManager.GetFragmentDataChecked<FHelicopterAmbientRouteFragment>(Entity).Destination = Item.Destination;
+}
+
+void UHelicopterAmbientTrafficSubsystem::RemoveReplicatedAmbient(int32 AmbientId)
+{
+	if (const int32* AmbientIndex = AmbientIndexById.Find(AmbientId))
+	{
+		RemoveAmbientAt(*AmbientIndex);
+	}
+}
+
+AHelicopterBasePawn* UHelicopterAmbientTrafficSubsystem::PromoteClosestAmbientHelicopter(FVector Location, float MaxDistance)
+{
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	if (!EntitySubsystem) return nullptr;
+
+	const FMassEntityManager& EntityManager = EntitySubsystem->GetEntityManager();
+	int32 ClosestIndex = INDEX_NONE;
+	float ClosestDistanceSquared = FMath::Square(MaxDistance);
+
+	for (int32 Index = 0; Index < AmbientEntities.Num(); Index++)
+	{
+		const FTransform& Transform = EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(AmbientEntities[Index]).Transform;
+		const float DistanceSquared = FVector::DistSquared(Transform.GetLocation(), Location);
+		if (DistanceSquared <= ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			ClosestIndex = Index;
+		}
+	}
+
+	return ClosestIndex != INDEX_NONE ? Promote(ClosestIndex) : nullptr;
+}
+
+void UHelicopterAmbientTrafficSubsystem::CreateAmbientEntity(int32 AmbientId, const FTransform& Transform, const FVector& Velocity, float YawSpeed, const FVector& Destination)
+{
+	FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager();
+	const FMassEntityHandle Entity = EntityManager.CreateEntity(AmbientArchetype, AmbientSharedValues);
+
+	EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(Entity).Transform = Transform;
+
+	FHelicopterAmbientFlightFragment& Flight = EntityManager.GetFragmentDataChecked<FHelicopterAmbientFlightFragment>(Entity);
+	Flight.Velocity = Velocity;
+	Flight.YawSpeed = YawSpeed;
+
+	EntityManager.GetFragmentDataChecked<FHelicopterAmbientRouteFragment>(Entity).Destination = Destination;
+
+	AmbientIndexById.Add(AmbientId, AmbientEntities.Num());
+	AmbientEntities.Add(Entity);
+	AmbientIds.Add(AmbientId);
+	if (Instances)
+	{
+		Instances->AddInstance(Transform, true);
+	}
+	if (Replicator)
+	{
+		Replicator->AddAmbient(AmbientId, Transform, Velocity, Destination);
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::RemoveAmbientAt(int32 AmbientIndex)
+{
+	GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager().DestroyEntity(AmbientEntities[AmbientIndex]);
+
+	// The last helicopter is swapped into the hole in every parallel list
+	AmbientIndexById.Remove(AmbientIds[AmbientIndex]);
+	if (AmbientIndex != AmbientIds.Num() - 1)
+	{
+		AmbientIndexById.Add(AmbientIds.Last(), AmbientIndex);
+	}
+
+	AmbientEntities.RemoveAtSwap(AmbientIndex);
+	AmbientIds.RemoveAtSwap(AmbientIndex);
+	if (Instances)
+	{
+		Instances->RemoveInstance(AmbientIndex);
+	}
+	if (Replicator)
+	{
+		Replicator->RemoveAmbientAtSwap(AmbientIndex);
+	}
+}
+
+AHelicopterBasePawn* UHelicopterAmbientTrafficSubsystem::Promote(int32 AmbientIndex)
+{
+	UWorld* World = GetWorld();
+	FMassEntityManager& EntityManager = World->GetSubsystem<UMassEntitySubsystem>()->GetMutableEntityManager();
+	const FMassEntityHandle Entity = AmbientEntities[AmbientIndex];
+
+	const FTransform Transform = EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(Entity).Transform;
+	const FHelicopterAmbientFlightFragment Flight = EntityManager.GetFragmentDataChecked<FHelicopterAmbientFlightFragment>(Entity);
+	const FVector Destination = EntityManager.GetFragmentDataChecked<FHelicopterAmbientRouteFragment>(Entity).Destination;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	AHelicopterBasePawn* Helicopter = World->SpawnActor<AHelicopterBasePawn>(HelicopterClass, Transform, SpawnParams);
+	if (!Helicopter || !Helicopter->HelicopterMover) return nullptr;
+
+	// Carry the flight state over so the swap is not visible
+	FHelicopterState State;
+	State.Position = Transform.GetLocation();
+	State.Rotation = Transform.Rotator();
+	State.Velocity = Flight.Velocity;
+	State.Timestamp = World->GetTimeSeconds();
+	Helicopter->HelicopterMover->SetMoverState(State, Flight.YawSpeed);
+	Helicopter->RestoreEngineState(EEngine_State::EES_EngineOn, 1.0f);
+
+	FHelicopterAutopilotOrder Order;
+	Order.Mode = EAutopilot_Mode::EAM_Waypoints;
+	Order.Waypoints.Add(Destination);
+	World->GetSubsystem<UHelicopterAutopilotSubsystem>()->EngageAutopilot(Helicopter->HelicopterMover, Order);
+
+	FHelicopterPromotedAmbient& PromotedAmbient = Promoted.AddDefaulted_GetRef();
+	PromotedAmbient.Helicopter = Helicopter;
+	PromotedAmbient.Destination = Destination;
+
+	RemoveAmbientAt(AmbientIndex);
+
+	return Helicopter;
+}
+
+void UHelicopterAmbientTrafficSubsystem::Demote(int32 PromotedIndex)
+{
+	AHelicopterBasePawn* Helicopter = Promoted[PromotedIndex].Helicopter.Get();
+	const FVector Destination = Promoted[PromotedIndex].Destination;
+	Promoted.RemoveAtSwap(PromotedIndex);
+
+	UHelicopterMoverComponent* Mover = Helicopter->HelicopterMover;
+	const FHelicopterState State = Mover->GetMoverState();
+
+	CreateAmbientEntity(NextAmbientId++, FTransform(State.Rotation, State.Position), State.Velocity, Mover->GetCurrentYawSpeed(), Destination);
+
+	GetWorld()->GetSubsystem<UHelicopterAutopilotSubsystem>()->DisengageAutopilot(Mover);
+	Helicopter->Destroy();
+}
+
+void UHelicopterAmbientTrafficSubsystem::UpdateLOD()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAmbientLOD);
+
+	TArray<FVector> ViewLocations;
+	GatherViewLocations(ViewLocations);
+
+	auto ClosestViewDistanceSquared = [&ViewLocations](const FVector& Location)
+	{
+		float Closest = TNumericLimits<float>::Max();
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			Closest = FMath::Min(Closest, static_cast<float>(FVector::DistSquared(ViewLocation, Location)));
+		}
+		return Closest;
+	};
+
+	const FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetEntityManager();
+	PromotionCandidates.Reset();
+	for (int32 Index = 0; Index < AmbientEntities.Num(); Index++)
+	{
+		const FTransform& Transform = EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(AmbientEntities[Index]).Transform;
+		const float DistanceSquared = ClosestViewDistanceSquared(Transform.GetLocation());
+		if (DistanceSquared <= FMath::Square(PromoteDistance))
+		{
+			PromotionCandidates.Emplace(DistanceSquared, Index);
+		}
+	}
+
+	// The rest wait for the next update, by then the closest are pawns and the next closest are in front
+	if (PromotionCandidates.Num() > MaxPromotionsPerUpdate)
+	{
+		PromotionCandidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+		PromotionCandidates.SetNum(FMath::Max(0, MaxPromotionsPerUpdate));
+	}
+
+	// Promoting swaps the last entity into the removed slot, so go from the highest index down
+	PromotionCandidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Value > B.Value; });
+	for (const TPair<float, int32>& Candidate : PromotionCandidates)
+	{
+		Promote(Candidate.Value);
+	}
+
+	UHelicopterAutopilotSubsystem* Autopilot = GetWorld()->GetSubsystem<UHelicopterAutopilotSubsystem>();
+	for (int32 Index = Promoted.Num() - 1; Index >= 0; Index--)
+	{
+		AHelicopterBasePawn* Helicopter = Promoted[Index].Helicopter.Get();
+		if (!Helicopter)
+		{
+			Promoted.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// Once a player has taken the helicopter over it stays a full pawn
+		if (Helicopter->IsPlayerControlled() || !Autopilot->IsAutopilotEngaged(Helicopter->HelicopterMover))
+		{
+			Promoted.RemoveAtSwap(Index);
+			continue;
+		}
+
+		if (ClosestViewDistanceSquared(Helicopter->GetActorLocation()) > FMath::Square(DemoteDistance))
+		{
+			Demote(Index);
+		}
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::UpdateInstances()
+{
+	if (!Instances || AmbientEntities.Num() == 0) return;
+
+	const FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetEntityManager();
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(AmbientEntities.Num());
+	for (const FMassEntityHandle& Entity : AmbientEntities)
+	{
+		Transforms.Add(EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(Entity).Transform);
+	}
+
+	Instances->BatchUpdateInstancesTransforms(0, Transforms, true, true);
+}
+
+void UHelicopterAmbientTrafficSubsystem::ResyncAmbient(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAmbientResync);
+	if (!Replicator || AmbientEntities.Num() == 0) return;
+
+	// Resend an even share every frame so the bandwidth stays flat instead of arriving in one burst per interval
+	ResyncBudget += AmbientEntities.Num() * DeltaTime / FMath::Max(AmbientResyncInterval, 0.1f);
+	const int32 NumToResync = FMath::Min(FMath::FloorToInt32(ResyncBudget), AmbientEntities.Num());
+	ResyncBudget -= NumToResync;
+
+	const FMassEntityManager& EntityManager = GetWorld()->GetSubsystem<UMassEntitySubsystem>()->GetEntityManager();
+	for (int32 Count = 0; Count < NumToResync; Count++)
+	{
+		ResyncCursor = ResyncCursor % AmbientEntities.Num();
+		const FMassEntityHandle Entity = AmbientEntities[ResyncCursor];
+
+		Replicator->UpdateAmbient(ResyncCursor,
+			EntityManager.GetFragmentDataChecked<FHelicopterAmbientTransformFragment>(Entity).Transform,
+			EntityManager.GetFragmentDataChecked<FHelicopterAmbientFlightFragment>(Entity).Velocity,
+			EntityManager.GetFragmentDataChecked<FHelicopterAmbientRouteFragment>(Entity).Destination);
+		ResyncCursor++;
+	}
+}
+
+void UHelicopterAmbientTrafficSubsystem::GatherViewLocations(TArray<FVector>& OutViewLocations) const
+{
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		if (const APlayerController* PlayerController = Iterator->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			OutViewLocations.Add(ViewLocation);
+		}
+	}
+}
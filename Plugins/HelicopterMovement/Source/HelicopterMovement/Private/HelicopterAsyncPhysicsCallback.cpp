@@ -0,0 +1,68 @@
+#include "HelicopterAsyncPhysicsCallback.h"
+#include "HelicopterMovement.h"
+
+DECLARE_CYCLE_STAT(TEXT("Async Physics Integrate"), STAT_HelicopterAsyncIntegrate, STATGROUP_HelicopterMovement);
+
+void FHelicopterAsyncPhysicsCallback::PushInputs_External(TArrayView<const FHelicopterAsyncMoverInput> Inputs)
+{
+	// The producer buffer is reused until the physics thread takes it, so always overwrite it with the newest inputs
+	FHelicopterAsyncInput* Input = GetProducerInputData_External();
+	Input->Movers.Reset(Inputs.Num());
+	Input->Movers.Append(Inputs.GetData(), Inputs.Num());
+}
+
+void FHelicopterAsyncPhysicsCallback::ConsumeOutputs_External()
+{
+	while (Chaos::TSimCallbackOutputHandle<FHelicopterAsyncOutput> Output = PopOutputData_External())
+	{
+		for (const FHelicopterAsyncMoverState& State : Output->Movers)
+		{
+			LatestStates_External.Add(State.Id, State);
+		}
+	}
+}
+
+void FHelicopterAsyncPhysicsCallback::OnPreSimulate_Internal()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAsyncIntegrate);
+
+	// Steps without fresh game thread input keep flying on the last inputs received
+	if (const FHelicopterAsyncInput* Input = GetConsumerInput_Internal())
+	{
+		LastInputs_Internal = Input->Movers;
+
+		ActiveIds_Internal.Reset();
+		for (const FHelicopterAsyncMoverInput& MoverInput : LastInputs_Internal)
+		{
+			ActiveIds_Internal.Add(MoverInput.State.Id);
+		}
+
+		// Forget helicopters the game thread stopped sending, they restart from their game thread state when they return
+		for (auto It = SimStates_Internal.CreateIterator(); It; ++It)
+		{
+			if (!ActiveIds_Internal.Contains(It.Key()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	const float DeltaTime = GetDeltaTime_Internal();
+	FHelicopterAsyncOutput& Output = GetProducerOutputData_Internal();
+	Output.Movers.Reset(LastInputs_Internal.Num());
+
+	for (const FHelicopterAsyncMoverInput& MoverInput : LastInputs_Internal)
+	{
+		FHelicopterAsyncMoverState* SimState = SimStates_Internal.Find(MoverInput.State.Id);
+		if (!SimState || SimState->StateVersion != MoverInput.State.StateVersion)
+		{
+			SimState = &SimStates_Internal.Add(MoverInput.State.Id, MoverInput.State);
+		}
+
+		SimState->Rotation = FHelicopterFlightModel::Integrate(SimState->Rotation, MoverInput.DesiredInput, MoverInput.DesiredYawInput,
+			MoverInput.Params, DeltaTime, SimState->Velocity, SimState->YawSpeed);
+		SimState->Position += SimState->Velocity * DeltaTime;
+
+		Output.Movers.Add(*SimState);
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "HelicopterFlightModel.h"
+
+/* * * Simulated state of one helicopter, tagged with the version of the game thread state it was started from * * */
+struct FHelicopterAsyncMoverState
+{
+	int32 Id = INDEX_NONE;
+	uint32 StateVersion = 0;
+	FVector Position = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+	float YawSpeed = 0.0f;
+};
+
+/* * * Inputs for one helicopter, the state is only applied when the version changes * * */
+struct FHelicopterAsyncMoverInput
+{
+	FHelicopterAsyncMoverState State;
+	FVector DesiredInput = FVector::ZeroVector;
+	float DesiredYawInput = 0.0f;
+	FHelicopterFlightParams Params;
+};
+
+struct FHelicopterAsyncInput : public Chaos::FSimCallbackInput
+{
+	TArray<FHelicopterAsyncMoverInput> Movers;
+
+	void Reset()
+	{
+		Movers.Reset();
+	}
+};
+
+struct FHelicopterAsyncOutput : public Chaos::FSimCallbackOutput
+{
+	TArray<FHelicopterAsyncMoverState> Movers;
+
+	void Reset()
+	{
+		Movers.Reset();
+	}
+};
+
+/* * * Steps the helicopter flight model on the physics thread at the fixed physics rate * * */
+// The game thread writes inputs into the callback's producer buffer and reads back the latest published states,
+// both handed over by Chaos without locks. Collision stays on the game thread, which sweeps to the simulated
+// position and bumps the state version on a hit so the physics thread restarts from the resolved state.
+class FHelicopterAsyncPhysicsCallback : public Chaos::TSimCallbackObject<FHelicopterAsyncInput, FHelicopterAsyncOutput>
+{
+public:
+	/* Game thread, queues the inputs for the next physics step */
+	void PushInputs_External(TArrayView<const FHelicopterAsyncMoverInput> Inputs);
+
+	/* Game thread, drains every published output and keeps the newest state of each helicopter */
+	void ConsumeOutputs_External();
+
+	/* Game thread, newest simulated state of a helicopter or null if none has been published yet */
+	const FHelicopterAsyncMoverState* FindLatestState_External(int32 Id) const { return LatestStates_External.Find(Id); }
+
+	/* Game thread, drops the published state of a helicopter that left the simulation */
+	void ForgetMover_External(int32 Id) { LatestStates_External.Remove(Id); }
+
+private:
+	virtual void OnPreSimulate_Internal() override;
+
+	/* Owned by the physics thread */
+	TMap<int32, FHelicopterAsyncMoverState> SimStates_Internal;
+	TArray<FHelicopterAsyncMoverInput> LastInputs_Internal;
+	TSet<int32> ActiveIds_Internal;
+
+	/* Owned by the game thread */
+	TMap<int32, FHelicopterAsyncMoverState> LatestStates_External;
+};
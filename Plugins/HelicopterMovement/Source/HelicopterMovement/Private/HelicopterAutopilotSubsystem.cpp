@@ -0,0 +1,217 @@
+#include "HelicopterAutopilotSubsystem.h"
+#include "HelicopterMovement.h"
+#include "HelicopterMoverComponent.h"
+#include "HelicopterBasePawn.h"
+#include "Components/SplineComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Autopilot Batch"), STAT_HelicopterAutopilotBatch, STATGROUP_HelicopterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Autopilot Helicopters"), STAT_HelicopterAutopilotCount, STATGROUP_HelicopterMovement);
+
+bool UHelicopterAutopilotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHelicopterAutopilotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAutopilotBatch);
+
+	// Drop helicopters that were destroyed while engaged
+	Pilots.RemoveAllSwap([](const FHelicopterAutopilot& Pilot) { return !Pilot.Mover.IsValid(); });
+	SET_DWORD_STAT(STAT_HelicopterAutopilotCount, Pilots.Num());
+
+	// Inputs computed here are consumed by the movers on the next frame's tick
+	for (FHelicopterAutopilot& Pilot : Pilots)
+	{
+		ComputeInputs(Pilot, *Pilot.Mover.Get(), DeltaTime);
+	}
+}
+
+bool UHelicopterAutopilotSubsystem::IsTickable() const
+{
+	return Pilots.Num() > 0 && GetWorld() && GetWorld()->GetNetMode() != NM_Client;
+}
+
+TStatId UHelicopterAutopilotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHelicopterAutopilotSubsystem, STATGROUP_Tickables);
+}
+
+void UHelicopterAutopilotSubsystem::EngageAutopilot(UHelicopterMoverComponent* Mover, const FHelicopterAutopilotOrder& Order)
+{
+	if (!Mover || !Mover->GetOwner() || !Mover->GetOwner()->HasAuthority()) return;
+
+	FHelicopterAutopilot* Pilot = Pilots.FindByPredicate([Mover](const FHelicopterAutopilot& Existing) { return Existing.Mover == Mover; });
+	if (!Pilot)
+	{
+		Pilot = &Pilots.AddDefaulted_GetRef();
+		Pilot->Mover = Mover;
+	}
+
+	Pilot->Order = Order;
+	Pilot->WaypointIndex = 0;
+	Pilot->PositionErrorIntegral = FVector::ZeroVector;
+	Pilot->HoldYaw = Mover->GetOwner()->GetActorRotation().Yaw;
+
+	Mover->SetAutopilotEngaged(true);
+}
+
+void UHelicopterAutopilotSubsystem::DisengageAutopilot(UHelicopterMoverComponent* Mover)
+{
+	if (!Mover) return;
+
+	const int32 RemovedCount = Pilots.RemoveAllSwap([Mover](const FHelicopterAutopilot& Pilot) { return Pilot.Mover == Mover; });
+	if (RemovedCount > 0)
+	{
+		Mover->DesiredInput = FVector::ZeroVector;
+		Mover->DesiredYawInput = 0.0f;
+		Mover->SetAutopilotEngaged(false);
+	}
+}
+
+bool UHelicopterAutopilotSubsystem::IsAutopilotEngaged(const UHelicopterMoverComponent* Mover) const
+{
+	return Pilots.ContainsByPredicate([Mover](const FHelicopterAutopilot& Pilot) { return Pilot.Mover == Mover; });
+}
+
+FVector UHelicopterAutopilotSubsystem::ComputeTargetLocation(FHelicopterAutopilot& Pilot, const FVector& Location)
+{
+	FHelicopterAutopilotOrder& Order = Pilot.Order;
+
+	switch (Order.Mode)
+	{
+	case EAutopilot_Mode::EAM_AltitudeHold:
+		// Only the height is held, the horizontal target follows the helicopter
+		return FVector(Location.X, Location.Y, Order.HoldLocation.Z);
+
+	case EAutopilot_Mode::EAM_Waypoints:
+	{
+		if (Order.Waypoints.Num() == 0) return Location;
+
+		if (FVector::Dist(Location, Order.Waypoints[Pilot.WaypointIndex]) <= Order.AcceptanceRadius)
+		{
+			if (Pilot.WaypointIndex + 1 < Order.Waypoints.Num())
+			{
+				Pilot.WaypointIndex++;
+			}
+			else if (Order.bLoopPath)
+			{
+				Pilot.WaypointIndex = 0;
+			}
+		}
+		return Order.Waypoints[Pilot.WaypointIndex];
+	}
+
+	case EAutopilot_Mode::EAM_Spline:
+	{
+		if (!Order.Spline) return Location;
+
+		// Aim a fixed distance ahead of the closest point on the spline
+		const float InputKey = Order.Spline->FindInputKeyClosestToWorldLocation(Location);
+		const float SplineLength = Order.Spline->GetSplineLength();
+		float TargetDistance = Order.Spline->GetDistanceAlongSplineAtSplineInputKey(InputKey) + Order.LookAheadDistance;
+
+		if (Order.bLoopPath || Order.Spline->IsClosedLoop())
+		{
+			TargetDistance = FMath::Fmod(TargetDistance, FMath::Max(SplineLength, UE_KINDA_SMALL_NUMBER));
+		}
+		else
+		{
+			TargetDistance = FMath::Min(TargetDistance, SplineLength);
+		}
+		return Order.Spline->GetLocationAtDistanceAlongSpline(TargetDistance, ESplineCoordinateSpace::World);
+	}
+
+	case EAutopilot_Mode::EAM_Orbit:
+	{
+		// Aim at a point on the circle the look ahead distance further around from the current bearing
+		const FVector2D Offset(Location.X - Order.OrbitCenter.X, Location.Y - Order.OrbitCenter.Y);
+		const float Radius = FMath::Max(Order.OrbitRadius, 1.0f);
+		const float LeadAngle = (Order.LookAheadDistance / Radius) * (Order.bOrbitClockwise ? 1.0f : -1.0f);
+		const float TargetAngle = FMath::Atan2(Offset.Y, Offset.X) + LeadAngle;
+
+		return FVector(
+			Order.OrbitCenter.X + FMath::Cos(TargetAngle) * Radius,
+			Order.OrbitCenter.Y + FMath::Sin(TargetAngle) * Radius,
+			Order.OrbitCenter.Z);
+	}
+
+	case EAutopilot_Mode::EAM_HoverHold:
+	default:
+		return Order.HoldLocation;
+	}
+}
+
+void UHelicopterAutopilotSubsystem::ComputeInputs(FHelicopterAutopilot& Pilot, UHelicopterMoverComponent& Mover, float DeltaTime)
+{
+	AActor* Owner = Mover.GetOwner();
+
+	// Respect the engine state the same way the player input handlers do
+	const AHelicopterBasePawn* Helicopter = Cast<AHelicopterBasePawn>(Owner);
+	if (Helicopter && Helicopter->EngineState != EEngine_State::EES_EngineOn)
+	{
+		Mover.DesiredInput = FVector::ZeroVector;
+		Mover.DesiredYawInput = 0.0f;
+		return;
+	}
+
+	const FVector Location = Owner->GetActorLocation();
+	const FRotator Rotation = Owner->GetActorRotation();
+	const FVector Velocity = Mover.GetCurrentVelocity();
+	const FHelicopterAutopilotOrder& Order = Pilot.Order;
+
+	/*
+	 * The mover eases its velocity toward the commanded one at a rate of VelocityDamping per second, so it behaves like a
+	 * first order lag with time constant 1 / VelocityDamping. The position loop is kept a quarter of that bandwidth so the
+	 * two loops do not fight, the derivative term leads by that lag and the integral only trims out steady offsets.
+	 */
+	const float Damping = FMath::Max(Mover.VelocityDamping, UE_KINDA_SMALL_NUMBER);
+	const float Kp = Damping * 0.25f;
+	const float Ki = Kp * Kp * 0.1f;
+	const float Kd = Kp / Damping;
+	const float CruiseSpeed = Order.CruiseSpeed > 0.0f ? Order.CruiseSpeed : Mover.MaxForwardSpeed;
+
+	const FVector TargetLocation = ComputeTargetLocation(Pilot, Location);
+	const FVector PositionError = TargetLocation - Location;
+
+	// Clamp the integral so it can never ask for more than a fraction of cruise speed
+	const float MaxIntegral = (CruiseSpeed * 0.2f) / FMath::Max(Ki, UE_KINDA_SMALL_NUMBER);
+	Pilot.PositionErrorIntegral = (Pilot.PositionErrorIntegral + PositionError * DeltaTime).GetClampedToMaxSize(MaxIntegral);
+
+	FVector DesiredVelocity = PositionError * Kp + Pilot.PositionErrorIntegral * Ki - Velocity * Kd;
+
+	FVector2D HorizontalVelocity(DesiredVelocity.X, DesiredVelocity.Y);
+	HorizontalVelocity = HorizontalVelocity.GetSafeNormal() * FMath::Min(HorizontalVelocity.Size(), CruiseSpeed);
+	DesiredVelocity.X = HorizontalVelocity.X;
+	DesiredVelocity.Y = HorizontalVelocity.Y;
+
+	// Convert the world space velocity into the same stick inputs the pawn would produce
+	FVector Input = FHelicopterFlightModel::ComputeInputForVelocity(Rotation, DesiredVelocity, Mover.GetFlightParams());
+
+	if (Order.Mode == EAutopilot_Mode::EAM_AltitudeHold)
+	{
+		Input.X = FMath::Clamp(Order.CruiseInput.X, -1.0f, 1.0f);
+		Input.Y = FMath::Clamp(Order.CruiseInput.Y, -1.0f, 1.0f);
+	}
+
+	Mover.DesiredInput = Input;
+
+	// Face the direction of travel when moving along a path, otherwise keep the heading the order started with
+	float TargetYaw = Pilot.HoldYaw;
+	if (Order.Mode != EAutopilot_Mode::EAM_HoverHold && Order.Mode != EAutopilot_Mode::EAM_AltitudeHold
+		&& HorizontalVelocity.SizeSquared() > FMath::Square(CruiseSpeed * 0.1f))
+	{
+		TargetYaw = FMath::RadiansToDegrees(FMath::Atan2(HorizontalVelocity.Y, HorizontalVelocity.X));
+	}
+
+	const float YawError = FMath::FindDeltaAngleDegrees(Rotation.Yaw, TargetYaw);
+	const float YawRateCommand = YawError * Damping * 0.5f;
+	Mover.DesiredYawInput = FMath::Clamp(YawRateCommand / FMath::Max(Mover.YawSpeed, 1.0f), -1.0f, 1.0f);
+
+	if (Mover.IsSleeping() && !(Input.IsNearlyZero() && FMath::IsNearlyZero(Mover.DesiredYawInput)))
+	{
+		Mover.WakeUp();
+	}
+}
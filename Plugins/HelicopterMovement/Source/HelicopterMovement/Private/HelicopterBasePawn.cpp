@@ -2,13 +2,23 @@
 
 #include "HelicopterBasePawn.h"
 #include "HelicopterMoverComponent.h"
+#include "HelicopterClockSyncComponent.h"
+#include "HelicopterReplicationGraph.h"
+#include "Components/SphereComponent.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/MovementComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "GameFramework/GameStateBase.h"
+#include "TimerManager.h"
 
 AHelicopterBasePawn::AHelicopterBasePawn()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 	bReplicates = true;
 
 	// Network Configuration
@@ -16,11 +26,21 @@ AHelicopterBasePawn::AHelicopterBasePawn()
 	MinNetUpdateFrequency = 30.0f;
 
 	// Components
+	// The simulation moves the collision root, the body only carries the tilt and correction smoothing
+	CollisionRoot = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionRoot"));
+	RootComponent = CollisionRoot;
+	// Radius follows the mover's swept sphere, see OnConstruction
+	CollisionRoot->InitSphereRadius(150.0f);
+	CollisionRoot->SetIsReplicated(true);
+	CollisionRoot->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	CollisionRoot->SetCollisionResponseToAllChannels(ECR_Block);
+
 	HelicopterBody = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("HelicopterBody"));
-	RootComponent = HelicopterBody;
-	HelicopterBody->SetIsReplicated(true);
-	HelicopterBody->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	HelicopterBody->SetCollisionResponseToAllChannels(ECR_Block);
+	HelicopterBody->SetupAttachment(CollisionRoot);
+	// The mesh is offset by the tilt and correction smoothing, only visibility traces see it so nothing collides where the simulation never was
+	HelicopterBody->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	HelicopterBody->SetCollisionResponseToAllChannels(ECR_Ignore);
+	HelicopterBody->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
 
 	MainRotor = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MainRotor"));
 	MainRotor->SetupAttachment(HelicopterBody);
@@ -30,22 +50,47 @@ AHelicopterBasePawn::AHelicopterBasePawn()
 
 	HelicopterMover = CreateDefaultSubobject<UHelicopterMoverComponent>(TEXT("HelicopterMover"));
 	HelicopterMover->SetIsReplicated(true);
+	HelicopterMover->SetVisualComponent(HelicopterBody);
+
+	ClockSync = CreateDefaultSubobject<UHelicopterClockSyncComponent>(TEXT("ClockSync"));
+
+	// Seats ride on the body so occupants follow its tilt and correction smoothing
+	PilotsSeat = CreateDefaultSubobject<USceneComponent>(TEXT("PilotsSeat"));
+	PilotsSeat->SetupAttachment(HelicopterBody);
+
+	LeftPassenger = CreateDefaultSubobject<USceneComponent>(TEXT("LeftPassenger"));
+	LeftPassenger->SetupAttachment(HelicopterBody);
+
+	RightPassenger = CreateDefaultSubobject<USceneComponent>(TEXT("RightPassenger"));
+	RightPassenger->SetupAttachment(HelicopterBody);
+
+	SeatedOccupantNetUpdateFrequency = 2.0f;
 
 	RotorSpinUpTime = 10.0f;
-	RotorSpeed = 0.0f;
 	bIsStartingUp = false;
 
 	EngineState = EEngine_State::EES_EngineOff;
 }
 
-void AHelicopterBasePawn::OnRep_RotorSpeed()
+void AHelicopterBasePawn::OnConstruction(const FTransform& Transform)
 {
-	
+	Super::OnConstruction(Transform);
+
+	// The root has to be the same shape every movement sweep uses, or the two disagree about what the helicopter touches
+	if (CollisionRoot && HelicopterMover)
+	{
+		CollisionRoot->SetSphereRadius(HelicopterMover->CollisionSphere);
+	}
+}
+
+void AHelicopterBasePawn::OnRep_EngineTransition()
+{
+	UpdateTickEnabled();
 }
 
 void AHelicopterBasePawn::OnRep_EngineState()
 {
-	
+	UpdateTickEnabled();
 }
 
 void AHelicopterBasePawn::BeginPlay()
@@ -60,18 +105,66 @@ void AHelicopterBasePawn::BeginPlay()
 			Subsystem->AddMappingContext(HelicopterInputMapping, 0);
 		}
 	}
+
+	UpdateTickEnabled();
 }
 
-void AHelicopterBasePawn::Tick(float DeltaSeconds)
+void AHelicopterBasePawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaSeconds);
-
-	// Only execute rotor speed updates on the server
+	// Nobody stays stuck in the seats of a helicopter that is going away
 	if (HasAuthority())
 	{
-		UpdateRotorSpeed(DeltaSeconds);
+		while (SeatAssignments.Num() > 0)
+		{
+			AActor* Occupant = SeatAssignments.Last().Occupant;
+			if (IsValid(Occupant))
+			{
+				UnseatOccupant(Occupant);
+			}
+			else
+			{
+				SeatAssignments.Pop();
+			}
+		}
 	}
-	// Always spin the rotors locally for visuals
+	else
+	{
+		for (const FHelicopterSeatAssignment& Assignment : SeatAssignments)
+		{
+			DetachSeatOccupant(Assignment);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AHelicopterBasePawn::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	// Bring a dormant helicopter back onto the network before its new pilot starts sending input
+	if (HelicopterMover)
+	{
+		HelicopterMover->WakeUp();
+	}
+}
+
+void AHelicopterBasePawn::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
+
+	// Runs on the owning client too when the controller replicates, which is when clock sync has to start pinging
+	if (ClockSync)
+	{
+		ClockSync->UpdateTickEnabled();
+	}
+}
+
+void AHelicopterBasePawn::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// Rotor speed is derived from the engine transition, so this only drives the visuals
 	SpinRotors(DeltaSeconds);
 }
 
@@ -105,7 +198,9 @@ void AHelicopterBasePawn::StartHelicopter()
 		Server_StartEngine();
 		return;
 	}
-	EngineState = EEngine_State::EES_Starting;
+	if (EngineState == EEngine_State::EES_EngineOn || EngineState == EEngine_State::EES_Starting) return;
+
+	BeginEngineTransition(EEngine_State::EES_EngineOn, GetRotorSpeed());
 }
 
 void AHelicopterBasePawn::StopHelicopter()
@@ -115,7 +210,83 @@ void AHelicopterBasePawn::StopHelicopter()
 		Server_StopEngine();
 		return;
 	}
-	EngineState = EEngine_State::EES_Stopping;
+	if (EngineState == EEngine_State::EES_EngineOff || EngineState == EEngine_State::EES_Stopping) return;
+
+	BeginEngineTransition(EEngine_State::EES_EngineOff, GetRotorSpeed());
+}
+
+void AHelicopterBasePawn::RestoreEngineState(EEngine_State NewState, float NewRotorSpeed)
+{
+	if (!HasAuthority()) return;
+
+	const bool bSpinningUp = NewState == EEngine_State::EES_EngineOn || NewState == EEngine_State::EES_Starting;
+	BeginEngineTransition(bSpinningUp ? EEngine_State::EES_EngineOn : EEngine_State::EES_EngineOff, NewRotorSpeed);
+}
+
+float AHelicopterBasePawn::GetRotorSpeed() const
+{
+	const float SpinTime = FMath::Max(RotorSpinUpTime, UE_KINDA_SMALL_NUMBER);
+	const float Elapsed = static_cast<float>(FMath::Max(GetServerTime() - EngineTransition.StartServerTime, 0.0));
+	const float Direction = EngineTransition.TargetState == EEngine_State::EES_EngineOn ? 1.0f : -1.0f;
+
+	return FMath::Clamp(EngineTransition.StartRotorSpeed + Direction * Elapsed / SpinTime, 0.0f, 1.0f);
+}
+
+void AHelicopterBasePawn::BeginEngineTransition(EEngine_State TargetState, float StartRotorSpeed)
+{
+	EngineTransition.TargetState = TargetState;
+	EngineTransition.StartServerTime = GetServerTime();
+	EngineTransition.StartRotorSpeed = FMath::Clamp(StartRotorSpeed, 0.0f, 1.0f);
+
+	const bool bSpinningUp = TargetState == EEngine_State::EES_EngineOn;
+	EngineState = bSpinningUp ? EEngine_State::EES_Starting : EEngine_State::EES_Stopping;
+
+	// Schedule the state change for when the rotors reach the target instead of polling every frame
+	const float RemainingSpeed = bSpinningUp ? 1.0f - EngineTransition.StartRotorSpeed : EngineTransition.StartRotorSpeed;
+	const float RemainingTime = RemainingSpeed * RotorSpinUpTime;
+	if (RemainingTime > 0.0f)
+	{
+		GetWorldTimerManager().SetTimer(EngineTransitionTimer, this, &AHelicopterBasePawn::FinishEngineTransition, RemainingTime, false);
+	}
+	else
+	{
+		GetWorldTimerManager().ClearTimer(EngineTransitionTimer);
+		FinishEngineTransition();
+	}
+
+	UpdateTickEnabled();
+
+	// A parked helicopter starting or stopping its engines is no longer at rest
+	if (HelicopterMover)
+	{
+		HelicopterMover->WakeUp();
+	}
+}
+
+void AHelicopterBasePawn::FinishEngineTransition()
+{
+	EngineState = EngineTransition.TargetState;
+	UpdateTickEnabled();
+}
+
+void AHelicopterBasePawn::UpdateTickEnabled()
+{
+	const bool bRotorsVisible = GetNetMode() != NM_DedicatedServer;
+	SetActorTickEnabled(bRotorsVisible && EngineState != EEngine_State::EES_EngineOff);
+}
+
+double AHelicopterBasePawn::GetServerTime() const
+{
+	if (ClockSync)
+	{
+		return ClockSync->GetServerTime();
+	}
+
+	const UWorld* World = GetWorld();
+	if (!World) return 0.0;
+
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
 }
 
 void AHelicopterBasePawn::Server_ToggleEngines_Implementation()
@@ -150,43 +321,220 @@ void AHelicopterBasePawn::Server_StopEngine_Implementation()
 	StopHelicopter();
 }
 
-void AHelicopterBasePawn::UpdateRotorSpeed(float DeltaTime)
+void AHelicopterBasePawn::SpinRotors(float DeltaTime)
+{
+	if (MainRotor && TailRotor)
+	{
+		const float RotorSpeed = GetRotorSpeed();
+		MainRotor->AddRelativeRotation(FRotator(0.0f, RotorSpeed * 720.0f * DeltaTime, 0.0f));
+		TailRotor->AddRelativeRotation(FRotator(RotorSpeed * 540.0f * DeltaTime, 0.0f, 0.0f));
+	}
+}
+
+USceneComponent* AHelicopterBasePawn::GetSeatComponent(int32 SeatIndex) const
 {
-	if (EngineState == EEngine_State::EES_Starting)
+	switch (SeatIndex)
 	{
-		// Spin-up logic
-		RotorSpeed = FMath::Clamp(RotorSpeed + DeltaTime / RotorSpinUpTime, 0.0f, 1.0f);
+	case 0: return PilotsSeat;
+	case 1: return LeftPassenger;
+	case 2: return RightPassenger;
+	default: return nullptr;
+	}
+}
 
-		if (RotorSpeed >= 1.0f)
+AActor* AHelicopterBasePawn::GetSeatOccupant(int32 SeatIndex) const
+{
+	for (const FHelicopterSeatAssignment& Assignment : SeatAssignments)
+	{
+		if (Assignment.SeatIndex == SeatIndex && IsValid(Assignment.Occupant))
 		{
-			// Transition to Engine On state once rotors reach full speed
-			EngineState = EEngine_State::EES_EngineOn;
+			return Assignment.Occupant;
 		}
 	}
-	else if (EngineState == EEngine_State::EES_Stopping)
+	return nullptr;
+}
+
+bool AHelicopterBasePawn::SeatOccupant(AActor* Occupant, int32 SeatIndex, FVector RelativeOffset)
+{
+	if (!HasAuthority() || !IsValid(Occupant) || Occupant == this || !GetSeatComponent(SeatIndex)) return false;
+
+	// Occupants destroyed while seated leave their entry behind
+	SeatAssignments.RemoveAll([](const FHelicopterSeatAssignment& Assignment) { return !IsValid(Assignment.Occupant); });
+	if (GetSeatOccupant(SeatIndex)) return false;
+
+	// Leaving the previous helicopter first restores the occupant, otherwise that helicopter would restore it under us later
+	AHelicopterBasePawn* PreviousHelicopter = Cast<AHelicopterBasePawn>(Occupant->GetAttachParentActor());
+	if (PreviousHelicopter && PreviousHelicopter != this)
 	{
-		// Spin-down logic
-		RotorSpeed = FMath::Clamp(RotorSpeed - DeltaTime / RotorSpinUpTime, 0.0f, 1.0f);
+		PreviousHelicopter->UnseatOccupant(Occupant);
+	}
 
-		if (RotorSpeed <= 0.0f)
+	// Moving seats keeps the occupant's original settings instead of saving the seated ones
+	FHelicopterSeatAssignment Assignment;
+	const int32 ExistingIndex = SeatAssignments.IndexOfByPredicate([Occupant](const FHelicopterSeatAssignment& Existing) { return Existing.Occupant == Occupant; });
+	if (ExistingIndex != INDEX_NONE)
+	{
+		Assignment = SeatAssignments[ExistingIndex];
+		SeatAssignments.RemoveAt(ExistingIndex);
+	}
+	else
+	{
+		const UPrimitiveComponent* OccupantRoot = Cast<UPrimitiveComponent>(Occupant->GetRootComponent());
+		Assignment.Occupant = Occupant;
+		Assignment.PreviousNetUpdateFrequency = Occupant->NetUpdateFrequency;
+		Assignment.bWasReplicatingMovement = Occupant->IsReplicatingMovement();
+		Assignment.bWasSimulatingPhysics = OccupantRoot && OccupantRoot->IsSimulatingPhysics();
+		Assignment.bWasCollisionEnabled = Occupant->GetActorEnableCollision();
+	}
+	Assignment.SeatIndex = static_cast<uint8>(SeatIndex);
+	Assignment.RelativeOffset = RelativeOffset;
+	SeatAssignments.Add(Assignment);
+
+	AttachSeatOccupant(Assignment);
+
+	// The seat assignment carries the occupant's position from here on, so it only has gameplay state left to send
+	Occupant->SetReplicateMovement(false);
+	Occupant->NetUpdateFrequency = FMath::Min(Occupant->NetUpdateFrequency, SeatedOccupantNetUpdateFrequency);
+	NotifyReplicationGraphOfOccupant(Occupant, true);
+
+	// A dormant helicopter would never send the new assignment
+	if (HelicopterMover)
+	{
+		HelicopterMover->WakeUp();
+	}
+	ForceNetUpdate();
+	return true;
+}
+
+void AHelicopterBasePawn::UnseatOccupant(AActor* Occupant)
+{
+	if (!HasAuthority() || !Occupant) return;
+
+	const int32 AssignmentIndex = SeatAssignments.IndexOfByPredicate([Occupant](const FHelicopterSeatAssignment& Assignment) { return Assignment.Occupant == Occupant; });
+	if (AssignmentIndex == INDEX_NONE) return;
+
+	const FHelicopterSeatAssignment Assignment = SeatAssignments[AssignmentIndex];
+	SeatAssignments.RemoveAt(AssignmentIndex);
+
+	DetachSeatOccupant(Assignment);
+
+	if (Assignment.bWasSimulatingPhysics)
+	{
+		if (UPrimitiveComponent* OccupantRoot = Cast<UPrimitiveComponent>(Occupant->GetRootComponent()))
 		{
-			// Transition to Engine Off state once rotors stop
-			EngineState = EEngine_State::EES_EngineOff;
+			OccupantRoot->SetSimulatePhysics(true);
 		}
 	}
-	else if (EngineState == EEngine_State::EES_EngineOff)
+
+	Occupant->NetUpdateFrequency = Assignment.PreviousNetUpdateFrequency;
+	Occupant->SetReplicateMovement(Assignment.bWasReplicatingMovement);
+	NotifyReplicationGraphOfOccupant(Occupant, false);
+	Occupant->ForceNetUpdate();
+
+	if (HelicopterMover)
 	{
-		// Ensure rotor speed is zero in the Engine Off state
-		RotorSpeed = 0.0f;
+		HelicopterMover->WakeUp();
 	}
+	ForceNetUpdate();
 }
 
-void AHelicopterBasePawn::SpinRotors(float DeltaTime)
+void AHelicopterBasePawn::OnRep_SeatAssignments(const TArray<FHelicopterSeatAssignment>& PreviousAssignments)
 {
-	if (MainRotor && TailRotor)
+	for (const FHelicopterSeatAssignment& Previous : PreviousAssignments)
 	{
-		MainRotor->AddRelativeRotation(FRotator(0.0f, RotorSpeed * 720.0f * DeltaTime, 0.0f));
-		TailRotor->AddRelativeRotation(FRotator(RotorSpeed * 540.0f * DeltaTime, 0.0f, 0.0f));
+		const bool bStillSeated = SeatAssignments.ContainsByPredicate([&Previous](const FHelicopterSeatAssignment& Assignment) { return Assignment.Occupant == Previous.Occupant; });
+		if (!bStillSeated)
+		{
+			DetachSeatOccupant(Previous);
+		}
+	}
+
+	// Also runs again once an occupant that was not relevant yet arrives and its reference resolves
+	for (const FHelicopterSeatAssignment& Assignment : SeatAssignments)
+	{
+		AttachSeatOccupant(Assignment);
+	}
+}
+
+void AHelicopterBasePawn::AttachSeatOccupant(const FHelicopterSeatAssignment& Assignment)
+{
+	AActor* Occupant = Assignment.Occupant;
+	USceneComponent* Seat = GetSeatComponent(Assignment.SeatIndex);
+	if (!IsValid(Occupant) || !Seat) return;
+
+	SetOccupantMovementSuspended(Occupant, true);
+
+	// Without collision the occupant is not pushed by or sweeping against the helicopter it sits in
+	Occupant->SetActorEnableCollision(false);
+
+	Occupant->AttachToComponent(Seat, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	Occupant->SetActorRelativeLocation(Assignment.RelativeOffset);
+}
+
+void AHelicopterBasePawn::DetachSeatOccupant(const FHelicopterSeatAssignment& Assignment)
+{
+	AActor* Occupant = Assignment.Occupant;
+	if (!IsValid(Occupant)) return;
+
+	// It may already sit in another helicopter whose assignment replicated first
+	const AActor* AttachParent = Occupant->GetAttachParentActor();
+	if (AttachParent && AttachParent != this) return;
+
+	if (AttachParent)
+	{
+		Occupant->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	}
+	SetOccupantMovementSuspended(Occupant, false);
+	Occupant->SetActorEnableCollision(Assignment.bWasCollisionEnabled);
+}
+
+void AHelicopterBasePawn::SetOccupantMovementSuspended(AActor* Occupant, bool bSuspended)
+{
+	// Seated occupants are carried by the attachment, their own movement would only fight it and cost a tick each
+	TInlineComponentArray<UMovementComponent*> MovementComponents(Occupant);
+	for (UMovementComponent* MovementComponent : MovementComponents)
+	{
+		MovementComponent->SetComponentTickEnabled(!bSuspended);
+	}
+
+	if (ACharacter* Character = Cast<ACharacter>(Occupant))
+	{
+		if (UCharacterMovementComponent* CharacterMovement = Character->GetCharacterMovement())
+		{
+			if (bSuspended)
+			{
+				CharacterMovement->StopMovementImmediately();
+				CharacterMovement->DisableMovement();
+			}
+			else
+			{
+				CharacterMovement->SetMovementMode(MOVE_Falling);
+			}
+		}
+	}
+
+	if (bSuspended)
+	{
+		if (UPrimitiveComponent* OccupantRoot = Cast<UPrimitiveComponent>(Occupant->GetRootComponent()))
+		{
+			OccupantRoot->SetSimulatePhysics(false);
+		}
+	}
+}
+
+void AHelicopterBasePawn::NotifyReplicationGraphOfOccupant(AActor* Occupant, bool bSeated)
+{
+	const UNetDriver* NetDriver = GetNetDriver();
+	UHelicopterReplicationGraph* Graph = NetDriver ? NetDriver->GetReplicationDriver<UHelicopterReplicationGraph>() : nullptr;
+	if (!Graph) return;
+
+	if (bSeated)
+	{
+		Graph->AddSeatedOccupant(this, Occupant);
+	}
+	else
+	{
+		Graph->RemoveSeatedOccupant(this, Occupant);
 	}
 }
 
@@ -199,6 +547,7 @@ void AHelicopterBasePawn::HandleMovementInput(const FInputActionValue& Value)
 	{
 		HelicopterMover->DesiredInput.X = Input.X; // Forward/Backward
 		HelicopterMover->DesiredInput.Y = Input.Y; // Left/Right
+		HelicopterMover->WakeUp();
 	}
 }
 
@@ -218,6 +567,7 @@ void AHelicopterBasePawn::HandleYawInput(const FInputActionValue& Value)
 	if (HelicopterMover)
 	{
 		HelicopterMover->DesiredYawInput = Value.Get<float>();
+		HelicopterMover->WakeUp();
 	}
 }
 
@@ -236,6 +586,7 @@ void AHelicopterBasePawn::HandleThrottleInput(const FInputActionValue& Value)
 	if (HelicopterMover)
 	{
 		HelicopterMover->DesiredInput.Z = Value.Get<float>();
+		HelicopterMover->WakeUp();
 	}
 }
 
@@ -251,6 +602,7 @@ void AHelicopterBasePawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>&
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AHelicopterBasePawn, RotorSpeed);
+	DOREPLIFETIME(AHelicopterBasePawn, EngineTransition);
 	DOREPLIFETIME(AHelicopterBasePawn, EngineState);
+	DOREPLIFETIME(AHelicopterBasePawn, SeatAssignments);
 }
@@ -0,0 +1,311 @@
+#include "HelicopterBenchmarkCommandlet.h"
+#include "HelicopterMovement.h"
+#include "HelicopterBasePawn.h"
+#include "HelicopterMoverComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+/* Zone layout, each zone is a square of helicopters around its center */
+static const FVector NearGroundZoneCenter(0.0f, 0.0f, 300.0f);
+static const FVector OpenAirZoneCenter(200000.0f, 0.0f, 20000.0f);
+static const FVector CollisionZoneCenter(-200000.0f, 0.0f, 1500.0f);
+static constexpr float HelicopterSpacing = 1500.0f;
+static constexpr float ObstacleSpacing = 3000.0f;
+static constexpr int32 ObstacleGridSize = 12;
+
+UHelicopterBenchmarkCommandlet::UHelicopterBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UHelicopterBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath = TEXT("/Game/TestMap");
+	FString CountsParam = TEXT("1,10,100,500,1000");
+	FString OutputBase = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("HelicopterBenchmark");
+	int32 NumFrames = 600;
+	int32 NumWarmupFrames = 60;
+	float DeltaTime = 1.0f / 60.0f;
+
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("Counts="), CountsParam);
+	FParse::Value(*Params, TEXT("Output="), OutputBase);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("WarmupFrames="), NumWarmupFrames);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+	const bool bParallel = FParse::Param(*Params, TEXT("Parallel"));
+	const bool bUseAsyncPhysics = FParse::Param(*Params, TEXT("Async"));
+	const bool bListen = FParse::Param(*Params, TEXT("Listen"));
+
+	TArray<FString> CountStrings;
+	CountsParam.ParseIntoArray(CountStrings, TEXT(","));
+
+	TArray<int32> Counts;
+	for (const FString& CountString : CountStrings)
+	{
+		Counts.Add(FMath::Clamp(FCString::Atoi(*CountString), 1, 1000));
+	}
+
+	if (Counts.Num() == 0 || NumFrames <= 0)
+	{
+		UE_LOG(LogHelicopterMovement, Error, TEXT("HelicopterBenchmark needs at least one count in -Counts= and a positive -Frames="));
+		return 1;
+	}
+
+	if (IConsoleVariable* ParallelMovement = IConsoleManager::Get().FindConsoleVariable(TEXT("heli.ParallelMovement")))
+	{
+		ParallelMovement->Set(bParallel ? 1 : 0);
+	}
+
+	// The physics scene reads this when it is created, so it must be set before the world loads
+	if (bUseAsyncPhysics)
+	{
+		UPhysicsSettings::Get()->bTickPhysicsAsync = true;
+	}
+
+	UWorld* World = LoadBenchmarkWorld(MapPath, bListen);
+	if (!World)
+	{
+		return 1;
+	}
+
+	UE_CLOG(!HELICOPTER_MOVEMENT_COUNTERS, LogHelicopterMovement, Warning, TEXT("Movement counters are compiled out of this build, mover ms and sweeps will read zero"));
+	FHelicopterMovementCounters::SetEnabled(true);
+
+	SpawnObstacles(World);
+
+	UE_LOG(LogHelicopterMovement, Display, TEXT("Helicopter benchmark on %s: %d frames at %.4fs, parallel %d, async physics %d"),
+		*MapPath, NumFrames, DeltaTime, bParallel, bUseAsyncPhysics);
+
+	TArray<FHelicopterBenchmarkResult> Results;
+	for (const int32 NumHelicopters : Counts)
+	{
+		const FHelicopterBenchmarkResult& Result = Results.Add_GetRef(RunBenchmark(World, NumHelicopters, NumWarmupFrames, NumFrames, DeltaTime, bUseAsyncPhysics));
+		UE_LOG(LogHelicopterMovement, Display, TEXT("  %4d helicopters: %.3f ms game thread (%.3f max), %.3f ms movers, %.1f sweeps/frame, %.0f bytes/frame, %.1f KB/helicopter"),
+			Result.NumHelicopters, Result.GameThreadMs, Result.GameThreadMaxMs, Result.MoverMs, Result.SweepsPerFrame, Result.ReplicatedBytesPerFrame, Result.MemoryPerHelicopterKB);
+	}
+
+	FHelicopterMovementCounters::SetEnabled(false);
+	DestroyBenchmarkWorld(World);
+
+	return WriteResults(OutputBase, Results) ? 0 : 1;
+}
+
+UWorld* UHelicopterBenchmarkCommandlet::LoadBenchmarkWorld(const FString& MapPath, bool bListen)
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPath, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogHelicopterMovement, Error, TEXT("Could not load benchmark map %s"), *MapPath);
+		return nullptr;
+	}
+
+	World->WorldType = EWorldType::Game;
+	World->AddToRoot();
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true).ShouldSimulatePhysics(true));
+	}
+	World->UpdateWorldComponents(true, false);
+
+	FURL URL;
+	if (bListen && !World->Listen(URL))
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Could not listen, replicated bytes will not be measured"));
+	}
+
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+
+	// There is no game mode in a commandlet world to start play, so dispatch BeginPlay directly
+	if (!World->GetBegunPlay())
+	{
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	return World;
+}
+
+void UHelicopterBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World)
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	CollectGarbage(RF_NoFlags);
+}
+
+void UHelicopterBenchmarkCommandlet::SpawnObstacles(UWorld* World)
+{
+	UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!CubeMesh) return;
+
+	// A field of tall pillars the collision heavy zone flies through
+	const float HalfExtent = (ObstacleGridSize - 1) * ObstacleSpacing * 0.5f;
+	for (int32 Index = 0; Index < ObstacleGridSize * ObstacleGridSize; Index++)
+	{
+		const FVector Location = CollisionZoneCenter + FVector((Index % ObstacleGridSize) * ObstacleSpacing - HalfExtent, (Index / ObstacleGridSize) * ObstacleSpacing - HalfExtent, 0.0f);
+		const FTransform Transform(FRotator::ZeroRotator, Location, FVector(8.0f, 8.0f, 60.0f));
+
+		AStaticMeshActor* Obstacle = World->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform);
+		if (!Obstacle) continue;
+
+		Obstacle->GetStaticMeshComponent()->SetStaticMesh(CubeMesh);
+		Obstacle->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Obstacle->FinishSpawning(Transform);
+	}
+}
+
+TArray<AHelicopterBasePawn*> UHelicopterBenchmarkCommandlet::SpawnHelicopters(UWorld* World, int32 NumHelicopters, bool bUseAsyncPhysics)
+{
+	TArray<AHelicopterBasePawn*> Helicopters;
+	Helicopters.Reserve(NumHelicopters);
+
+	// Every third helicopter goes to the same zone, so each zone gets an even share at any count
+	const int32 PerZone = FMath::DivideAndRoundUp(NumHelicopters, 3);
+	const int32 GridSize = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(static_cast<float>(PerZone))));
+	const float HalfExtent = (GridSize - 1) * HelicopterSpacing * 0.5f;
+	const FVector ZoneCenters[] = { NearGroundZoneCenter, OpenAirZoneCenter, CollisionZoneCenter };
+
+	for (int32 Index = 0; Index < NumHelicopters; Index++)
+	{
+		const int32 IndexInZone = Index / 3;
+		const FVector Location = ZoneCenters[Index % 3] + FVector((IndexInZone % GridSize) * HelicopterSpacing - HalfExtent, (IndexInZone / GridSize) * HelicopterSpacing - HalfExtent, 0.0f);
+		const FTransform Transform(FRotator(0.0f, Index * 37.0f, 0.0f), Location);
+
+		AHelicopterBasePawn* Helicopter = World->SpawnActorDeferred<AHelicopterBasePawn>(AHelicopterBasePawn::StaticClass(), Transform,
+			nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (!Helicopter) continue;
+
+		if (Helicopter->HelicopterMover)
+		{
+			Helicopter->HelicopterMover->bUseAsyncPhysics = bUseAsyncPhysics;
+		}
+
+		Helicopter->FinishSpawning(Transform);
+		Helicopter->RestoreEngineState(EEngine_State::EES_EngineOn, 1.0f);
+		Helicopters.Add(Helicopter);
+	}
+
+	return Helicopters;
+}
+
+void UHelicopterBenchmarkCommandlet::ApplyScriptedInputs(const TArray<AHelicopterBasePawn*>& Helicopters, int32 Frame, float DeltaTime)
+{
+	const float Time = Frame * DeltaTime;
+
+	for (int32 Index = 0; Index < Helicopters.Num(); Index++)
+	{
+		UHelicopterMoverComponent* Mover = Helicopters[Index]->HelicopterMover;
+		if (!Mover) continue;
+
+		// Phase shifted per helicopter so they do not all manoeuvre in lockstep
+		const float Phase = Time * 0.5f + Index * 0.73f;
+		FVector Input(FMath::Sin(Phase), FMath::Cos(Phase * 0.7f) * 0.5f, FMath::Sin(Phase * 1.3f) * 0.3f);
+
+		// Near ground helicopters keep pushing down into the ground so they slide and bounce
+		if (Index % 3 == 0)
+		{
+			Input.Z = -0.2f + FMath::Sin(Phase * 1.3f) * 0.3f;
+		}
+
+		Mover->DesiredInput = Input;
+		Mover->DesiredYawInput = FMath::Sin(Phase * 0.4f) * 0.5f;
+		Mover->WakeUp();
+	}
+}
+
+FHelicopterBenchmarkResult UHelicopterBenchmarkCommandlet::RunBenchmark(UWorld* World, int32 NumHelicopters, int32 NumWarmupFrames, int32 NumFrames, float DeltaTime, bool bUseAsyncPhysics)
+{
+	FHelicopterBenchmarkResult Result;
+	Result.NumFrames = NumFrames;
+
+	CollectGarbage(RF_NoFlags);
+	const uint64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+	TArray<AHelicopterBasePawn*> Helicopters = SpawnHelicopters(World, NumHelicopters, bUseAsyncPhysics);
+	Result.NumHelicopters = Helicopters.Num();
+
+	for (int32 Frame = 0; Frame < NumWarmupFrames; Frame++)
+	{
+		ApplyScriptedInputs(Helicopters, Frame, DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+	}
+
+	// Measured after the warm up so pools and buffers that grow on first use are counted
+	const uint64 MemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+	Result.MemoryPerHelicopterKB = MemoryAfter > MemoryBefore ? (MemoryAfter - MemoryBefore) / 1024.0 / FMath::Max(Result.NumHelicopters, 1) : 0.0;
+
+	const UNetDriver* NetDriver = World->GetNetDriver();
+	const int64 OutBytesBefore = NetDriver ? static_cast<int64>(NetDriver->OutTotalBytes) : 0;
+	FHelicopterMovementCounters::Reset();
+
+	double TotalMs = 0.0;
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		ApplyScriptedInputs(Helicopters, NumWarmupFrames + Frame, DeltaTime);
+
+		const double StartTime = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, DeltaTime);
+		const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+		TotalMs += FrameMs;
+		Result.GameThreadMaxMs = FMath::Max(Result.GameThreadMaxMs, FrameMs);
+		GFrameCounter++;
+	}
+
+	Result.GameThreadMs = TotalMs / NumFrames;
+	Result.MoverMs = FPlatformTime::ToMilliseconds64(FHelicopterMovementCounters::GetMoverCycles()) / NumFrames;
+	Result.SweepsPerFrame = static_cast<double>(FHelicopterMovementCounters::GetNumSweeps()) / NumFrames;
+	Result.ReplicatedBytesPerFrame = NetDriver ? static_cast<double>(static_cast<int64>(NetDriver->OutTotalBytes) - OutBytesBefore) / NumFrames : 0.0;
+
+	for (AHelicopterBasePawn* Helicopter : Helicopters)
+	{
+		Helicopter->Destroy();
+	}
+
+	return Result;
+}
+
+bool UHelicopterBenchmarkCommandlet::WriteResults(const FString& OutputBase, const TArray<FHelicopterBenchmarkResult>& Results) const
+{
+	FString Csv = TEXT("NumHelicopters,NumFrames,GameThreadMs,GameThreadMaxMs,MoverMs,SweepsPerFrame,ReplicatedBytesPerFrame,MemoryPerHelicopterKB\n");
+	FString Json = TEXT("[\n");
+
+	for (int32 Index = 0; Index < Results.Num(); Index++)
+	{
+		const FHelicopterBenchmarkResult& Result = Results[Index];
+		Csv += FString::Printf(TEXT("%d,%d,%.4f,%.4f,%.4f,%.2f,%.1f,%.2f\n"),
+			Result.NumHelicopters, Result.NumFrames, Result.GameThreadMs, Result.GameThreadMaxMs, Result.MoverMs,
+			Result.SweepsPerFrame, Result.ReplicatedBytesPerFrame, Result.MemoryPerHelicopterKB);
+		Json += FString::Printf(TEXT("\t{ \"NumHelicopters\": %d, \"NumFrames\": %d, \"GameThreadMs\": %.4f, \"GameThreadMaxMs\": %.4f, \"MoverMs\": %.4f, ")
+			TEXT("\"SweepsPerFrame\": %.2f, \"ReplicatedBytesPerFrame\": %.1f, \"MemoryPerHelicopterKB\": %.2f }%s\n"),
+			Result.NumHelicopters, Result.NumFrames, Result.GameThreadMs, Result.GameThreadMaxMs, Result.MoverMs,
+			Result.SweepsPerFrame, Result.ReplicatedBytesPerFrame, Result.MemoryPerHelicopterKB, Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+	Json += TEXT("]\n");
+
+	const bool bSaved = FFileHelper::SaveStringToFile(Csv, *(OutputBase + TEXT(".csv"))) && FFileHelper::SaveStringToFile(Json, *(OutputBase + TEXT(".json")));
+	UE_CLOG(bSaved, LogHelicopterMovement, Display, TEXT("Helicopter benchmark results written to %s.csv and .json"), *OutputBase);
+	UE_CLOG(!bSaved, LogHelicopterMovement, Error, TEXT("Could not write helicopter benchmark results to %s"), *OutputBase);
+	return bSaved;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HelicopterBenchmarkCommandlet.generated.h"
+
+/* Forward Declarations */
+class AHelicopterBasePawn;
+
+/* * * Results of one benchmark run at a given helicopter count * * */
+struct FHelicopterBenchmarkResult
+{
+	int32 NumHelicopters = 0;
+	int32 NumFrames = 0;
+	double GameThreadMs = 0.0;
+	double GameThreadMaxMs = 0.0;
+	double MoverMs = 0.0;
+	double SweepsPerFrame = 0.0;
+	double ReplicatedBytesPerFrame = 0.0;
+	double MemoryPerHelicopterKB = 0.0;
+};
+
+/* * * Headless helicopter scaling benchmark * * */
+// Loads a map, spawns helicopters spread over near ground, open air and collision heavy zones, flies them with
+// scripted inputs for a fixed number of frames and writes the timings to CSV and JSON. Run it with
+// UnrealEditor-Cmd HelicopterSystem.uproject -run=HelicopterBenchmark -nullrhi -unattended [-Map=/Game/TestMap]
+// [-Counts=1,10,100,500,1000] [-Frames=600] [-WarmupFrames=60] [-Output=Saved/Benchmarks/HelicopterBenchmark]
+// [-Parallel] [-Async] [-Listen]. Replicated bytes are only non zero with -Listen and clients connected.
+// The game thread vs async physics comparison at 128 helicopters is two runs, compare their MoverMs columns:
+//   -run=HelicopterBenchmark -Counts=128 -Output=Saved/Benchmarks/HelicopterBenchmark_GameThread
+//   -run=HelicopterBenchmark -Counts=128 -Async -Output=Saved/Benchmarks/HelicopterBenchmark_Async
+// -Async turns on Tick Physics Async for the benchmark world only, the project leaves it off.
+UCLASS()
+class UHelicopterBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHelicopterBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	UWorld* LoadBenchmarkWorld(const FString& MapPath, bool bListen);
+	void DestroyBenchmarkWorld(UWorld* World);
+
+	void SpawnObstacles(UWorld* World);
+	TArray<AHelicopterBasePawn*> SpawnHelicopters(UWorld* World, int32 NumHelicopters, bool bUseAsyncPhysics);
+	void ApplyScriptedInputs(const TArray<AHelicopterBasePawn*>& Helicopters, int32 Frame, float DeltaTime);
+
+	FHelicopterBenchmarkResult RunBenchmark(UWorld* World, int32 NumHelicopters, int32 NumWarmupFrames, int32 NumFrames, float DeltaTime, bool bUseAsyncPhysics);
+	bool WriteResults(const FString& OutputBase, const TArray<FHelicopterBenchmarkResult>& Results) const;
+};
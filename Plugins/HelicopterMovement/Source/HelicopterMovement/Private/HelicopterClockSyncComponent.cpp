@@ -0,0 +1,133 @@
+#include "HelicopterClockSyncComponent.h"
+#include "HelicopterMovement.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Pawn.h"
+
+UHelicopterClockSyncComponent::UHelicopterClockSyncComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	PingInterval = 2.0f;
+	InitialPingInterval = 0.2f;
+	SampleWindowSize = 8;
+	SnapThreshold = 0.25f;
+
+	NextSampleIndex = 0;
+	Offset = 0.0;
+	BestRoundTripTime = 0.0;
+	bHasOffset = false;
+
+	PrimaryComponentTick.TickInterval = InitialPingInterval;
+	SetIsReplicatedByDefault(true);
+}
+
+void UHelicopterClockSyncComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UpdateTickEnabled();
+}
+
+void UHelicopterClockSyncComponent::UpdateTickEnabled()
+{
+	// Only the owning client pings, the server and simulated proxies read the server clock directly
+	SetComponentTickEnabled(IsOwningClient());
+}
+
+double UHelicopterClockSyncComponent::GetServerTime() const
+{
+	const UWorld* World = GetWorld();
+	if (!World) return 0.0;
+
+	if (World->GetNetMode() != NM_Client)
+	{
+		return World->GetTimeSeconds();
+	}
+
+	if (bHasOffset)
+	{
+		return GetLocalTime() + Offset;
+	}
+
+	// Fall back to the game state's coarser estimate until the first pong arrives
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+void UHelicopterClockSyncComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Ticks at the ping interval
+	Server_Ping(GetLocalTime());
+}
+
+void UHelicopterClockSyncComponent::Server_Ping_Implementation(double ClientSendTime)
+{
+	Client_Pong(ClientSendTime, GetWorld()->GetTimeSeconds());
+}
+
+void UHelicopterClockSyncComponent::Client_Pong_Implementation(double ClientSendTime, double ServerTime)
+{
+	const double Now = GetLocalTime();
+
+	FHelicopterClockSample Sample;
+	Sample.RoundTripTime = FMath::Max(Now - ClientSendTime, 0.0);
+	Sample.Offset = ServerTime + Sample.RoundTripTime * 0.5 - Now;
+	AddSample(Sample);
+}
+
+bool UHelicopterClockSyncComponent::IsOwningClient() const
+{
+	const APawn* OwningPawn = Cast<APawn>(GetOwner());
+	return OwningPawn && OwningPawn->IsLocallyControlled() && GetWorld()->GetNetMode() == NM_Client;
+}
+
+double UHelicopterClockSyncComponent::GetLocalTime() const
+{
+	// World time on both ends, the same clock the server answers with and the game state replicates for the fallback
+	return GetWorld()->GetTimeSeconds();
+}
+
+void UHelicopterClockSyncComponent::AddSample(const FHelicopterClockSample& Sample)
+{
+	const int32 WindowSize = FMath::Max(SampleWindowSize, 1);
+	if (Samples.Num() < WindowSize)
+	{
+		Samples.Add(Sample);
+	}
+	else
+	{
+		Samples[NextSampleIndex % WindowSize] = Sample;
+	}
+	NextSampleIndex = (NextSampleIndex + 1) % WindowSize;
+
+	// Trust the lowest round trip in the window, it has the least queueing delay and so the least offset error
+	const FHelicopterClockSample* Best = &Samples[0];
+	for (const FHelicopterClockSample& Candidate : Samples)
+	{
+		if (Candidate.RoundTripTime < Best->RoundTripTime)
+		{
+			Best = &Candidate;
+		}
+	}
+	BestRoundTripTime = Best->RoundTripTime;
+
+	// Slew small changes so predicted timestamps do not jump around, snap large ones
+	if (!bHasOffset || FMath::Abs(Best->Offset - Offset) > SnapThreshold)
+	{
+		Offset = Best->Offset;
+	}
+	else
+	{
+		Offset = FMath::Lerp(Offset, Best->Offset, 0.1);
+	}
+
+	// Keep the fallback clock until a few samples are in
+	if (!bHasOffset && Samples.Num() >= FMath::Min(WindowSize, 3))
+	{
+		bHasOffset = true;
+		SetComponentTickInterval(PingInterval);
+	}
+}
@@ -0,0 +1,304 @@
+#include "HelicopterFleetSnapshotSubsystem.h"
+#include "HelicopterMovement.h"
+#include "HelicopterMoverComponent.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fleet Snapshot Restore"), STAT_HelicopterSnapshotRestore, STATGROUP_HelicopterMovement);
+
+void FHelicopterSnapshotEntry::Serialize(FArchive& Ar, int32 Version)
+{
+	Ar << ClassIndex;
+	Ar << Position;
+	Ar << Rotation;
+	Ar << Velocity;
+	Ar << YawSpeed;
+	Ar << EngineState;
+	Ar << RotorSpeed;
+
+	if (Version >= 2)
+	{
+		// Same layout as serializing the array, but a count no helicopter could have is rejected before allocating
+		int32 NumSeats = Seats.Num();
+		Ar << NumSeats;
+		if (Ar.IsLoading())
+		{
+			if (NumSeats < 0 || NumSeats > AHelicopterBasePawn::NumSeats)
+			{
+				Ar.SetError();
+				return;
+			}
+			Seats.SetNum(NumSeats);
+		}
+
+		for (FHelicopterSnapshotSeat& Seat : Seats)
+		{
+			Ar << Seat;
+		}
+	}
+}
+
+/* Players come back on their own when they reconnect, only occupants the server spawned are saved */
+static bool IsSavedOccupant(const AActor* Occupant)
+{
+	const APawn* OccupantPawn = Cast<APawn>(Occupant);
+	return IsValid(Occupant) && !(OccupantPawn && OccupantPawn->IsPlayerControlled());
+}
+
+bool UHelicopterFleetSnapshotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UHelicopterFleetSnapshotSubsystem::SaveSnapshot(TArray<uint8>& OutData) const
+{
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client) return false;
+
+	// Classes are stored once and referenced by index, most fleets only use a handful
+	TArray<FSoftClassPath> Classes;
+	TArray<FHelicopterSnapshotEntry> Entries;
+
+	for (TActorIterator<AHelicopterBasePawn> It(World); It; ++It)
+	{
+		const AHelicopterBasePawn* Helicopter = *It;
+		if (!IsValid(Helicopter) || !Helicopter->HelicopterMover) continue;
+
+		const FHelicopterState State = Helicopter->HelicopterMover->GetMoverState();
+
+		FHelicopterSnapshotEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.ClassIndex = static_cast<uint16>(Classes.AddUnique(FSoftClassPath(Helicopter->GetClass())));
+		Entry.Position = State.Position;
+		Entry.Rotation = State.Rotation;
+		Entry.Velocity = State.Velocity;
+		Entry.YawSpeed = Helicopter->HelicopterMover->GetCurrentYawSpeed();
+		Entry.EngineState = Helicopter->EngineState;
+		Entry.RotorSpeed = Helicopter->GetRotorSpeed();
+
+		for (const FHelicopterSeatAssignment& Assignment : Helicopter->GetSeatAssignments())
+		{
+			if (!IsSavedOccupant(Assignment.Occupant)) continue;
+
+			FHelicopterSnapshotSeat& Seat = Entry.Seats.AddDefaulted_GetRef();
+			Seat.OccupantClassIndex = static_cast<uint16>(Classes.AddUnique(FSoftClassPath(Assignment.Occupant->GetClass())));
+			Seat.SeatIndex = Assignment.SeatIndex;
+			Seat.RelativeOffset = Assignment.RelativeOffset;
+		}
+	}
+
+	OutData.Reset();
+	FMemoryWriter Writer(OutData);
+
+	uint32 Magic = SnapshotMagic;
+	int32 Version = SnapshotVersion;
+	Writer << Magic;
+	Writer << Version;
+	Writer << Classes;
+
+	int32 NumEntries = Entries.Num();
+	Writer << NumEntries;
+	for (FHelicopterSnapshotEntry& Entry : Entries)
+	{
+		Entry.Serialize(Writer, Version);
+	}
+
+	UE_LOG(LogHelicopterMovement, Log, TEXT("Saved %d helicopters to a %d byte fleet snapshot"), NumEntries, OutData.Num());
+	return true;
+}
+
+int32 UHelicopterFleetSnapshotSubsystem::RestoreSnapshot(const TArray<uint8>& Data, bool bDestroyExisting)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterSnapshotRestore);
+	const double StartTime = FPlatformTime::Seconds();
+
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client) return 0;
+
+	FMemoryReader Reader(Data);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Reader.IsError() || Magic != SnapshotMagic || Version < 1 || Version > SnapshotVersion)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Not a helicopter fleet snapshot this build can read (version %d)"), Version);
+		return 0;
+	}
+
+	// Read the class table by hand so its count is bounded too, every path takes at least the length of an empty string
+	int32 NumClasses = 0;
+	Reader << NumClasses;
+	const int64 MaxClasses = FMath::Min<int64>((Reader.TotalSize() - Reader.Tell()) / sizeof(int32), MAX_uint16 + 1);
+	if (Reader.IsError() || NumClasses < 0 || NumClasses > MaxClasses)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Helicopter fleet snapshot claims %d classes but only has room for %lld"), NumClasses, MaxClasses);
+		return 0;
+	}
+
+	TArray<FSoftClassPath> ClassPaths;
+	ClassPaths.SetNum(NumClasses);
+	for (FSoftClassPath& ClassPath : ClassPaths)
+	{
+		Reader << ClassPath;
+	}
+
+	int32 NumEntries = 0;
+	Reader << NumEntries;
+
+	// Never allocate more entries than the bytes left could hold, whatever count the file claims
+	const int64 MaxEntries = (Reader.TotalSize() - Reader.Tell()) / FHelicopterSnapshotEntry::MinSerializedSize;
+	if (Reader.IsError() || NumEntries < 0 || NumEntries > MaxEntries)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Helicopter fleet snapshot claims %d helicopters but only has room for %lld"), NumEntries, MaxEntries);
+		return 0;
+	}
+
+	TArray<FHelicopterSnapshotEntry> Entries;
+	Entries.SetNum(NumEntries);
+	for (FHelicopterSnapshotEntry& Entry : Entries)
+	{
+		Entry.Serialize(Reader, Version);
+		if (Reader.IsError())
+		{
+			UE_LOG(LogHelicopterMovement, Warning, TEXT("Helicopter fleet snapshot is truncated or corrupt"));
+			return 0;
+		}
+	}
+
+	TArray<UClass*> Classes;
+	for (const FSoftClassPath& ClassPath : ClassPaths)
+	{
+		// The table holds helicopter and occupant classes since version 2
+		UClass* Class = ClassPath.TryLoadClass<AActor>();
+		UE_CLOG(!Class, LogHelicopterMovement, Warning, TEXT("Class %s in the fleet snapshot could not be loaded"), *ClassPath.ToString());
+		Classes.Add(Class);
+	}
+
+	if (bDestroyExisting)
+	{
+		for (TActorIterator<AHelicopterBasePawn> It(World); It; ++It)
+		{
+			// Saved occupants are spawned again with their helicopter
+			for (const FHelicopterSeatAssignment& Assignment : It->GetSeatAssignments())
+			{
+				if (IsSavedOccupant(Assignment.Occupant))
+				{
+					Assignment.Occupant->Destroy();
+				}
+			}
+			It->Destroy();
+		}
+	}
+
+	// Spawn everything with construction deferred, construction scripts and BeginPlay wait until the whole fleet exists
+	TArray<TPair<AHelicopterBasePawn*, const FHelicopterSnapshotEntry*>> Spawned;
+	Spawned.Reserve(Entries.Num());
+
+	for (const FHelicopterSnapshotEntry& Entry : Entries)
+	{
+		UClass* Class = Classes.IsValidIndex(Entry.ClassIndex) ? Classes[Entry.ClassIndex] : nullptr;
+		if (!Class || !Class->IsChildOf<AHelicopterBasePawn>()) continue;
+
+		AHelicopterBasePawn* Helicopter = World->SpawnActorDeferred<AHelicopterBasePawn>(Class, FTransform(Entry.Rotation, Entry.Position),
+			nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (Helicopter)
+		{
+			Spawned.Emplace(Helicopter, &Entry);
+		}
+	}
+
+	// Then construct and begin play each one, and put it back in the state it was saved in
+	for (const TPair<AHelicopterBasePawn*, const FHelicopterSnapshotEntry*>& Pair : Spawned)
+	{
+		AHelicopterBasePawn* Helicopter = Pair.Key;
+		const FHelicopterSnapshotEntry& Entry = *Pair.Value;
+
+		Helicopter->FinishSpawning(FTransform(Entry.Rotation, Entry.Position));
+		if (!Helicopter->HelicopterMover) continue;
+
+		FHelicopterState State;
+		State.Position = Entry.Position;
+		State.Rotation = Entry.Rotation;
+		State.Velocity = Entry.Velocity;
+		State.Timestamp = World->GetTimeSeconds();
+		Helicopter->HelicopterMover->SetMoverState(State, Entry.YawSpeed);
+		Helicopter->RestoreEngineState(Entry.EngineState, Entry.RotorSpeed);
+	}
+
+	// Seat occupants last, once every helicopter is in its saved place
+	int32 NumOccupants = 0;
+	for (const TPair<AHelicopterBasePawn*, const FHelicopterSnapshotEntry*>& Pair : Spawned)
+	{
+		AHelicopterBasePawn* Helicopter = Pair.Key;
+		for (const FHelicopterSnapshotSeat& Seat : Pair.Value->Seats)
+		{
+			UClass* OccupantClass = Classes.IsValidIndex(Seat.OccupantClassIndex) ? Classes[Seat.OccupantClassIndex] : nullptr;
+			const USceneComponent* SeatComponent = Helicopter->GetSeatComponent(Seat.SeatIndex);
+			if (!OccupantClass || OccupantClass->IsChildOf<AHelicopterBasePawn>() || !SeatComponent) continue;
+
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			AActor* Occupant = World->SpawnActor<AActor>(OccupantClass, SeatComponent->GetComponentTransform(), SpawnParams);
+			if (Occupant && Helicopter->SeatOccupant(Occupant, Seat.SeatIndex, Seat.RelativeOffset))
+			{
+				NumOccupants++;
+			}
+		}
+	}
+
+	UE_LOG(LogHelicopterMovement, Log, TEXT("Restored %d helicopters and %d occupants from a version %d fleet snapshot in %.2f ms"),
+		Spawned.Num(), NumOccupants, Version, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	return Spawned.Num();
+}
+
+bool UHelicopterFleetSnapshotSubsystem::SaveSnapshotToFile(const FString& FilePath) const
+{
+	TArray<uint8> Data;
+	return SaveSnapshot(Data) && FFileHelper::SaveArrayToFile(Data, *FilePath);
+}
+
+int32 UHelicopterFleetSnapshotSubsystem::RestoreSnapshotFromFile(const FString& FilePath, bool bDestroyExisting)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *FilePath))
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Could not read helicopter fleet snapshot %s"), *FilePath);
+		return 0;
+	}
+	return RestoreSnapshot(Data, bDestroyExisting);
+}
+
+FString UHelicopterFleetSnapshotSubsystem::GetDefaultSnapshotPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("HelicopterFleet.snapshot");
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GHelicopterSnapshotSaveCmd(
+	TEXT("heli.Snapshot.Save"),
+	TEXT("Saves every helicopter in the world to a fleet snapshot.\n")
+	TEXT("Usage: heli.Snapshot.Save [FilePath=Saved/HelicopterFleet.snapshot]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UHelicopterFleetSnapshotSubsystem* Snapshots = World ? World->GetSubsystem<UHelicopterFleetSnapshotSubsystem>() : nullptr)
+		{
+			Snapshots->SaveSnapshotToFile(Args.Num() > 0 ? Args[0] : UHelicopterFleetSnapshotSubsystem::GetDefaultSnapshotPath());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GHelicopterSnapshotLoadCmd(
+	TEXT("heli.Snapshot.Load"),
+	TEXT("Replaces the helicopters in the world with the ones in a fleet snapshot.\n")
+	TEXT("Usage: heli.Snapshot.Load [FilePath=Saved/HelicopterFleet.snapshot]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UHelicopterFleetSnapshotSubsystem* Snapshots = World ? World->GetSubsystem<UHelicopterFleetSnapshotSubsystem>() : nullptr)
+		{
+			Snapshots->RestoreSnapshotFromFile(Args.Num() > 0 ? Args[0] : UHelicopterFleetSnapshotSubsystem::GetDefaultSnapshotPath(), true);
+		}
+	}));
@@ -1,9 +1,18 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "HelicopterMovement.h"
+#include "HelicopterTelemetrySubsystem.h"
 
 #define LOCTEXT_NAMESPACE "FHelicopterMovementModule"
 
+DEFINE_LOG_CATEGORY(LogHelicopterMovement);
+
+#if HELICOPTER_MOVEMENT_COUNTERS
+std::atomic<bool> FHelicopterMovementCounters::bEnabled { false };
+std::atomic<uint64> FHelicopterMovementCounters::NumSweeps { 0 };
+std::atomic<uint64> FHelicopterMovementCounters::MoverCycles { 0 };
+#endif
+
 void FHelicopterMovementModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -13,6 +22,9 @@ void FHelicopterMovementModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+
+	// Make sure a recording left running is flushed to disk
+	UHelicopterTelemetrySubsystem::StopRecording();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -1,6 +1,19 @@
 #include "HelicopterMoverComponent.h"
+#include "HelicopterMoverSubsystem.h"
+#include "HelicopterClockSyncComponent.h"
+#include "HelicopterTelemetrySubsystem.h"
+#include "HelicopterMovement.h"
 #include "Net/UnrealNetwork.h"
 #include "GameFramework/Actor.h"
+#include "GameFramework/Pawn.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Client Corrections"), STAT_HelicopterClientCorrections, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Game Thread Apply Input"), STAT_HelicopterApplyInput, STATGROUP_HelicopterMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sleeping Movers"), STAT_HelicopterSleepingMovers, STATGROUP_HelicopterMovement);
+
+/* Roughly two seconds of predictions at 60Hz */
+static constexpr int32 MaxPredictedStates = 128;
 
 UHelicopterMoverComponent::UHelicopterMoverComponent()
 {
@@ -12,7 +25,8 @@ UHelicopterMoverComponent::UHelicopterMoverComponent()
 	YawSpeed = 90.0f;
 
 	VelocityDamping = 0.95f;
-	CorrectionInterpolation = 5.0f;
+	VisualCorrectionHalfLife = 0.1f;
+	MaxVisualCorrectionDistance = 500.0f;
 
 	PositionErrorThreshold = 10.0f;
 	RotationErrorThreshold = 5.0f;
@@ -26,41 +40,92 @@ UHelicopterMoverComponent::UHelicopterMoverComponent()
 	SurfaceFriction = 0.9f;
 	SkidVelocityThreshold = 400.0f;
 
+	bAllowSleep = true;
+	SleepVelocityThreshold = 5.0f;
+	SleepDelay = 1.0f;
+	GroundProbeDistance = 25.0f;
+	SleepCheckInterval = 0.5f;
+
+	bUseAsyncPhysics = false;
+	AsyncPhysicsId = INDEX_NONE;
+	AsyncStateVersion = 0;
+	TelemetryId = 0;
+
+	bAutopilotEngaged = false;
+	bIsSleeping = false;
+	RestingTime = 0.0f;
+	VisualBaseTransform = FTransform::Identity;
+	VisualLocationOffset = FVector::ZeroVector;
+	VisualRotationOffset = FQuat::Identity;
+	CurrentTilt = FRotator::ZeroRotator;
+	LastProcessedInputTimestamp = -1.0;
+	LastSentInputTimestamp = -1.0;
+
 	SetIsReplicatedByDefault(true);
 }
 
 void UHelicopterMoverComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	ClockSync = GetOwner()->FindComponentByClass<UHelicopterClockSyncComponent>();
+	TelemetryId = UHelicopterTelemetrySubsystem::MakeHelicopterId();
+
+	// Pick up any relative transform a Blueprint gave the mesh after construction
+	SetVisualComponent(VisualComponent);
+
+	if (UHelicopterMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UHelicopterMoverSubsystem>())
+	{
+		MoverSubsystem->RegisterMover(this);
+	}
+}
+
+void UHelicopterMoverComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bIsSleeping && GetOwner()->HasAuthority())
+	{
+		DEC_DWORD_STAT(STAT_HelicopterSleepingMovers);
+		GetWorld()->GetTimerManager().ClearTimer(SleepCheckTimer);
+	}
+
+	if (UHelicopterMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UHelicopterMoverSubsystem>())
+	{
+		MoverSubsystem->UnregisterMover(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UHelicopterMoverComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	FHelicopterMoverCycleScope MoverCycleScope;
 	
 	
 	if (GetOwner()->HasAuthority())
 	{
-		// Update authoritative state
-		ServerState.Position = GetOwner()->GetActorLocation();
-		ServerState.Rotation = GetOwner()->GetActorRotation();
-		ServerState.Velocity = CurrentVelocity;
-		ServerState.Timestamp = GetWorld()->GetTimeSeconds();
-		ApplyInput(DeltaTime);
+		// In parallel mode the subsystem integrates every authoritative helicopter in one batched pass
+		const UHelicopterMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UHelicopterMoverSubsystem>();
+		if (!MoverSubsystem || !MoverSubsystem->IsDrivingMover(this))
+		{
+			ApplyInput(DeltaTime);
+		}
 	}
-	else
+	else if (!bAutopilotEngaged)
 	{
 		// Simulate client-side movement
 		ApplyInput(DeltaTime);
 
-		// Save predicted state
-		SavePredictedState(GetWorld()->GetTimeSeconds());
+		// Save predicted state. The synced clock can step backwards while it converges, the labels must not
+		const double Timestamp = FMath::Max(GetSyncedTime(), LastSentInputTimestamp + UE_KINDA_SMALL_NUMBER);
+		LastSentInputTimestamp = Timestamp;
+		SavePredictedState(Timestamp);
 
 		// Send input to the server
 		FHelicopterInput Input;
 		Input.DesiredInput = DesiredInput;
 		Input.DesiredYawInput = DesiredYawInput;
-		Input.Timestamp = GetWorld()->GetTimeSeconds();
+		Input.Timestamp = Timestamp;
 		Server_SendInput(Input);
 
 		// Reconcile state with server
@@ -68,19 +133,29 @@ void UHelicopterMoverComponent::TickComponent(float DeltaTime, ELevelTick TickTy
 	}
 
 	// Apply this after all the corrections have been made
+	DecayVisualCorrection(DeltaTime);
 	ApplyBodyTilt(DeltaTime);
+
+	if (GetOwner()->HasAuthority())
+	{
+		UpdateSleep(DeltaTime);
+	}
 }
 
 void UHelicopterMoverComponent::Server_SendInput_Implementation(const FHelicopterInput& Input)
 {
+	// The autopilot owns the inputs of AI helicopters
+	if (bAutopilotEngaged) return;
+
+	// Reliable RPCs arrive in order and clients send increasing timestamps, the clamp only guards the label
 	DesiredInput = Input.DesiredInput;
 	DesiredYawInput = Input.DesiredYawInput;
+	LastProcessedInputTimestamp = FMath::Max(LastProcessedInputTimestamp, Input.Timestamp);
 
-	// Update server state
-	ServerState.Position = GetOwner()->GetActorLocation();
-	ServerState.Rotation = GetOwner()->GetActorRotation();
-	ServerState.Velocity = CurrentVelocity;
-	ServerState.Timestamp = Input.Timestamp;
+	if (!HasNoInput())
+	{
+		WakeUp();
+	}
 }
 
 bool UHelicopterMoverComponent::Server_SendInput_Validate(const FHelicopterInput& Input)
@@ -93,6 +168,22 @@ void UHelicopterMoverComponent::OnRep_ServerState()
 	CorrectClientState();
 }
 
+void UHelicopterMoverComponent::OnRep_IsSleeping()
+{
+	// Clients stop predicting a parked helicopter along with the server
+	SetComponentTickEnabled(!bIsSleeping);
+	if (!bIsSleeping)
+	{
+		PredictedStates.Reset();
+	}
+	else
+	{
+		// No tick will fade the offset while asleep, settle the mesh now
+		ResetVisualCorrection();
+		ApplyBodyTilt(0.0f);
+	}
+}
+
 void UHelicopterMoverComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
@@ -103,6 +194,9 @@ void UHelicopterMoverComponent::GetLifetimeReplicatedProps(TArray<FLifetimePrope
 	// Helicopter Velocity
 	DOREPLIFETIME(UHelicopterMoverComponent, CurrentVelocity);
 
+	DOREPLIFETIME(UHelicopterMoverComponent, bAutopilotEngaged);
+	DOREPLIFETIME(UHelicopterMoverComponent, bIsSleeping);
+
 	// Replicate the server state for correction
 	DOREPLIFETIME(UHelicopterMoverComponent, ServerState);
 }
@@ -121,62 +215,218 @@ bool UHelicopterMoverComponent::IsOwnerLocallyControlled() const
 	return false;
 }
 
-void UHelicopterMoverComponent::ApplyInput(float DeltaTime)
+void UHelicopterMoverComponent::SetAutopilotEngaged(bool bEngaged)
 {
-	FVector Forward = GetOwner()->GetActorForwardVector();
-	FVector Right = GetOwner()->GetActorRightVector();
-	FVector Up = FVector::UpVector;
+	bAutopilotEngaged = bEngaged;
 
-	// Calculate target velocity
-	FVector TargetVelocity =
-		Forward * DesiredInput.X * MaxForwardSpeed +
-		Right * DesiredInput.Y * MaxLateralSpeed +
-		Up * DesiredInput.Z * MaxVerticalSpeed;
+	// Nothing will be reconciled against predictions made before the autopilot took over
+	if (bAutopilotEngaged)
+	{
+		PredictedStates.Reset();
+	}
+}
 
-	// Smooth velocity
-	CurrentVelocity = FMath::VInterpTo(CurrentVelocity, TargetVelocity, DeltaTime, VelocityDamping);
+FHelicopterState UHelicopterMoverComponent::GetMoverState() const
+{
+	FHelicopterState State;
+	State.Position = GetOwner()->GetActorLocation();
+	State.Rotation = GetOwner()->GetActorRotation();
+	State.Velocity = CurrentVelocity;
+	State.Timestamp = GetSyncedTime();
+	return State;
+}
 
-	// Perform collision-aware movement
-	FHitResult HitResult;
-	FVector Start = GetOwner()->GetActorLocation();
-	FVector End = Start + CurrentVelocity * DeltaTime;
+void UHelicopterMoverComponent::SetMoverState(const FHelicopterState& State, float InYawSpeed)
+{
+	GetOwner()->SetActorLocationAndRotation(State.Position, State.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	CurrentVelocity = State.Velocity;
+	CurrentYawSpeed = InYawSpeed;
+
+	UpdateServerState();
+	PredictedStates.Reset();
+	AsyncStateVersion++;
+	WakeUp();
+}
 
-	FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionSphere);
+void UHelicopterMoverComponent::AddImpulse(FVector VelocityChange)
+{
+	CurrentVelocity += VelocityChange;
+	AsyncStateVersion++;
+	WakeUp();
+}
+
+void UHelicopterMoverComponent::WakeUp()
+{
+	RestingTime = 0.0f;
+	if (!bIsSleeping) return;
+
+	bIsSleeping = false;
+	AsyncStateVersion++;
+	SetComponentTickEnabled(true);
 
-	bool bHit = GetWorld()->SweepSingleByChannel(
+	// Clients wake locally so they can predict and send input straight away, the server follows when the input arrives
+	if (GetOwner()->HasAuthority())
+	{
+		DEC_DWORD_STAT(STAT_HelicopterSleepingMovers);
+		GetWorld()->GetTimerManager().ClearTimer(SleepCheckTimer);
+		GetOwner()->FlushNetDormancy();
+		GetOwner()->SetNetDormancy(DORM_Awake);
+	}
+}
+
+void UHelicopterMoverComponent::UpdateSleep(float DeltaTime)
+{
+	const bool bResting = HasNoInput()
+		&& CurrentVelocity.SizeSquared() <= FMath::Square(SleepVelocityThreshold)
+		&& FMath::Abs(CurrentYawSpeed) <= SleepVelocityThreshold;
+
+	if (!bAllowSleep || !bResting)
+	{
+		RestingTime = 0.0f;
+		return;
+	}
+
+	RestingTime += DeltaTime;
+
+	// Only probe for ground once the helicopter has been still for a while, and a hovering one only every SleepCheckInterval
+	if (RestingTime >= SleepDelay)
+	{
+		if (IsGrounded())
+		{
+			GoToSleep();
+		}
+		else
+		{
+			RestingTime = SleepDelay - SleepCheckInterval;
+		}
+	}
+}
+
+bool UHelicopterMoverComponent::HasNoInput() const
+{
+	return DesiredInput.IsNearlyZero() && FMath::IsNearlyZero(DesiredYawInput);
+}
+
+bool UHelicopterMoverComponent::IsGrounded() const
+{
+	FHitResult HitResult;
+	const FVector Start = GetOwner()->GetActorLocation();
+	const FVector End = Start - FVector(0.0f, 0.0f, GroundProbeDistance + ImpactOffset);
+
+	FHelicopterMovementCounters::CountSweeps(1);
+	return GetWorld()->SweepSingleByChannel(
 		HitResult,
 		Start,
 		End,
 		FQuat::Identity,
 		ECC_WorldStatic,
+		FCollisionShape::MakeSphere(CollisionSphere),
+		FCollisionQueryParams(FName(TEXT("GroundProbe")), true, GetOwner())
+	) && HitResult.IsValidBlockingHit();
+}
+
+void UHelicopterMoverComponent::GoToSleep()
+{
+	bIsSleeping = true;
+	INC_DWORD_STAT(STAT_HelicopterSleepingMovers);
+
+	CurrentVelocity = FVector::ZeroVector;
+	CurrentYawSpeed = 0.0f;
+	UpdateServerState();
+
+	SetComponentTickEnabled(false);
+	GetWorld()->GetTimerManager().SetTimer(SleepCheckTimer, this, &UHelicopterMoverComponent::CheckSleepingSupport, SleepCheckInterval, true);
+
+	// Unoccupied helicopters stop replicating entirely, a possessed one stays awake on the network so its input RPCs keep flowing
+	const APawn* OwningPawn = Cast<APawn>(GetOwner());
+	if (!OwningPawn || !OwningPawn->GetController())
+	{
+		GetOwner()->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void UHelicopterMoverComponent::CheckSleepingSupport()
+{
+	// Wake up if whatever the helicopter was resting on has gone
+	if (!IsGrounded())
+	{
+		WakeUp();
+	}
+}
+
+void UHelicopterMoverComponent::ApplyInput(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterApplyInput);
+
+	FHelicopterMove Move;
+	PrepareMove(DeltaTime, Move);
+	SweepMove(Move);
+	FHelicopterMovementCounters::CountSweeps(1);
+	CommitMove(Move, DeltaTime);
+}
+
+void UHelicopterMoverComponent::PrepareMove(float DeltaTime, FHelicopterMove& OutMove)
+{
+	const FRotator CurrentRotation = GetOwner()->GetActorRotation();
+
+	// Smooth velocity and yaw toward the input targets
+	OutMove.Rotation = FHelicopterFlightModel::Integrate(CurrentRotation, DesiredInput, DesiredYawInput,
+		GetFlightParams(), DeltaTime, CurrentVelocity, CurrentYawSpeed);
+
+	OutMove.Start = GetOwner()->GetActorLocation();
+	OutMove.End = OutMove.Start + CurrentVelocity * DeltaTime;
+}
+
+void UHelicopterMoverComponent::SweepMove(FHelicopterMove& Move) const
+{
+	// Perform collision-aware movement
+	FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionSphere);
+
+	Move.bHit = GetWorld()->SweepSingleByChannel(
+		Move.HitResult,
+		Move.Start,
+		Move.End,
+		FQuat::Identity,
+		ECC_WorldStatic,
 		CollisionShape,
 		FCollisionQueryParams(FName(TEXT("HelicopterSweep")), true, GetOwner())
 	);
+}
 
-	if (bHit && HitResult.IsValidBlockingHit())
+void UHelicopterMoverComponent::CommitMove(const FHelicopterMove& Move, float DeltaTime)
+{
+	if (Move.bHit && Move.HitResult.IsValidBlockingHit())
 	{
-		HandleCollision(HitResult, DeltaTime);
+		UHelicopterTelemetrySubsystem::RecordSweepHit(this, Move.HitResult);
+		HandleCollision(Move.HitResult, DeltaTime);
 	}
 	else
 	{
 		// No collision, move normally
-		GetOwner()->SetActorLocation(End, true);
+		GetOwner()->SetActorLocation(Move.End, true);
 	}
-	
-	// Calculate yaw
-	float TargetYawSpeed = DesiredYawInput * YawSpeed;
-	CurrentYawSpeed = FMath::FInterpTo(CurrentYawSpeed, TargetYawSpeed, DeltaTime, VelocityDamping);
 
-	// Apply yaw without overriding pitch and roll
-	FRotator CurrentRotation = GetOwner()->GetActorRotation();
-	float NewYaw = CurrentRotation.Yaw + CurrentYawSpeed * DeltaTime;
+	GetOwner()->SetActorRotation(Move.Rotation);
+
+	// Captured after the move, the same point the client saves its prediction for the input, whichever path moved it
+	if (GetOwner()->HasAuthority())
+	{
+		UpdateServerState();
+	}
+}
 
-	// Preserve the pitch and roll while updating yaw
-	FRotator NewRotation = FRotator(CurrentRotation.Pitch, NewYaw, CurrentRotation.Roll);
-	GetOwner()->SetActorRotation(NewRotation);
+FHelicopterFlightParams UHelicopterMoverComponent::GetFlightParams() const
+{
+	FHelicopterFlightParams Params;
+	Params.MaxForwardSpeed = MaxForwardSpeed;
+	Params.MaxLateralSpeed = MaxLateralSpeed;
+	Params.MaxVerticalSpeed = MaxVerticalSpeed;
+	Params.YawSpeed = YawSpeed;
+	Params.VelocityDamping = VelocityDamping;
+	return Params;
 }
 
-void UHelicopterMoverComponent::SavePredictedState(float Timestamp)
+void UHelicopterMoverComponent::SavePredictedState(double Timestamp)
 {
 	FHelicopterState PredictedState;
 	PredictedState.Position = GetOwner()->GetActorLocation();
@@ -184,56 +434,54 @@ void UHelicopterMoverComponent::SavePredictedState(float Timestamp)
 	PredictedState.Velocity = CurrentVelocity;
 	PredictedState.Timestamp = Timestamp;
 	PredictedStates.Add(PredictedState);
+
+	// Do not grow forever if the server stops answering
+	if (PredictedStates.Num() > MaxPredictedStates)
+	{
+		PredictedStates.RemoveAt(0, PredictedStates.Num() - MaxPredictedStates);
+	}
 }
 
 void UHelicopterMoverComponent::ReconcileState()
 {
 	if (PredictedStates.Num() == 0)	return;
 
-	FHelicopterState LastPredictedState = PredictedStates[0];
-	PredictedStates.RemoveAt(0);
-
-	FHitResult HitResult;
-	FVector Start = GetOwner()->GetActorLocation();
-	FVector End = ServerState.Position;
-	
-	// Sweep to ensure collision compliance
-	FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionSphere); // Adjust size as needed
-	bool bHit = GetWorld()->SweepSingleByChannel(
-		HitResult,
-		Start,
-		End,
-		FQuat::Identity,
-		ECC_WorldStatic,
-		CollisionShape,
-		FCollisionQueryParams(FName(TEXT("ReconcileSweep")), true, GetOwner())
-	);
-
-	if (bHit && HitResult.IsValidBlockingHit())
+	// Match the prediction made for the last input the server applied, both are stamped on the server clock
+	int32 MatchIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < PredictedStates.Num() && PredictedStates[Index].Timestamp <= ServerState.Timestamp; Index++)
 	{
-		HandleCollision(HitResult, GetWorld()->DeltaTimeSeconds);
+		MatchIndex = Index;
 	}
-	else
-	{
-		// Check for mismatches
-		if (!LastPredictedState.Position.Equals(ServerState.Position, PositionErrorThreshold))
-		{
-			// Correct position
-			GetOwner()->SetActorLocation(ServerState.Position, true);
-		}
 
-		if (!LastPredictedState.Rotation.Equals(ServerState.Rotation, RotationErrorThreshold))
-		{
-			// Correct rotation
-			GetOwner()->SetActorRotation(ServerState.Rotation);
-		}
+	// The server has not applied any of the outstanding inputs yet
+	if (MatchIndex == INDEX_NONE) return;
 
-		// Reapply remaining predicted inputs
-		for (int32 i = 1; i < PredictedStates.Num(); i++)
-		{
-			ApplyInput(GetWorld()->DeltaTimeSeconds);
-		}
+	FHelicopterState LastPredictedState = PredictedStates[MatchIndex];
+	PredictedStates.RemoveAt(0, MatchIndex + 1);
+
+	const bool bPositionError = !LastPredictedState.Position.Equals(ServerState.Position, PositionErrorThreshold);
+	const bool bRotationError = !LastPredictedState.Rotation.Equals(ServerState.Rotation, RotationErrorThreshold);
+	if (!bPositionError && !bRotationError) return;
+
+	INC_DWORD_STAT(STAT_HelicopterClientCorrections);
+	UHelicopterTelemetrySubsystem::RecordCorrection(this, ServerState.Position - LastPredictedState.Position);
+
+	// Snap the simulation to the server's state without a sweep, the server already resolved any collision on the way there
+	const FTransform PreviousTransform = GetOwner()->GetActorTransform();
+	GetOwner()->SetActorLocationAndRotation(ServerState.Position, ServerState.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	CurrentVelocity = ServerState.Velocity;
+
+	// Reapply the predictions the server has not confirmed yet, and keep them in step with the corrected path
+	for (FHelicopterState& PredictedState : PredictedStates)
+	{
+		ApplyInput(GetWorld()->DeltaTimeSeconds);
+		PredictedState.Position = GetOwner()->GetActorLocation();
+		PredictedState.Rotation = GetOwner()->GetActorRotation();
+		PredictedState.Velocity = CurrentVelocity;
 	}
+
+	// The mesh stays where it was drawn and fades onto the corrected path
+	AddVisualCorrection(PreviousTransform);
 }
 
 void UHelicopterMoverComponent::UpdateServerState()
@@ -241,7 +489,13 @@ void UHelicopterMoverComponent::UpdateServerState()
 	ServerState.Position = GetOwner()->GetActorLocation();
 	ServerState.Rotation = GetOwner()->GetActorRotation();
 	ServerState.Velocity = CurrentVelocity;
-	ServerState.Timestamp = GetWorld()->GetTimeSeconds();
+	// Player driven helicopters are labeled with the last input applied so the client can match its prediction
+	ServerState.Timestamp = LastProcessedInputTimestamp >= 0.0 ? LastProcessedInputTimestamp : GetSyncedTime();
+}
+
+double UHelicopterMoverComponent::GetSyncedTime() const
+{
+	return ClockSync ? ClockSync->GetServerTime() : GetWorld()->GetTimeSeconds();
 }
 
 void UHelicopterMoverComponent::HandleCollision(const FHitResult& HitResult, float DeltaTime)
@@ -285,7 +539,7 @@ void UHelicopterMoverComponent::HandleCollision(const FHitResult& HitResult, flo
 		CurrentVelocity = SlidingVelocity;
 		GetOwner()->SetActorLocation(NewPosition, true);
 
-		UE_LOG(LogTemp, Log, TEXT("Helicopter sliding along surface. New Position: %s, New Velocity: %s"),
+		UE_LOG(LogHelicopterMovement, Verbose, TEXT("Helicopter sliding along surface. New Position: %s, New Velocity: %s"),
 			   *NewPosition.ToString(), *CurrentVelocity.ToString());
 	}
 }
@@ -294,10 +548,6 @@ void UHelicopterMoverComponent::ApplyBodyTilt(float DeltaTime)
 {
 	if (!GetOwner()) return;
 
-	// Get the helicopter's body mesh (if it exists)
-	UStaticMeshComponent* HelicopterBody = Cast<UStaticMeshComponent>(GetOwner()->GetRootComponent());
-	if (!HelicopterBody) return;
-
 	FVector ForwardVector = GetOwner()->GetActorForwardVector();
 	FVector RightVector = GetOwner()->GetActorRightVector();
 
@@ -309,6 +559,24 @@ void UHelicopterMoverComponent::ApplyBodyTilt(float DeltaTime)
 	TargetPitch = FMath::Clamp(TargetPitch, -MaxTiltAngle, MaxTiltAngle);
 	TargetRoll = FMath::Clamp(TargetRoll, -MaxTiltAngle, MaxTiltAngle);
 
+	if (HasVisualOffsetComponent())
+	{
+		// Smoothly interpolate to the target tilt
+		CurrentTilt = FMath::RInterpTo(CurrentTilt, FRotator(TargetPitch, 0.0f, TargetRoll), DeltaTime, TiltSmoothingSpeed);
+
+		// The offsets are kept in world space so they stay put while the helicopter turns, bring them into the actor's space
+		const FQuat ActorQuat = GetOwner()->GetActorQuat();
+		const FVector RelativeLocation = VisualBaseTransform.GetLocation() + ActorQuat.UnrotateVector(VisualLocationOffset);
+		const FQuat RelativeRotation = ActorQuat.Inverse() * VisualRotationOffset * ActorQuat * CurrentTilt.Quaternion() * VisualBaseTransform.GetRotation();
+
+		VisualComponent->SetRelativeLocationAndRotation(RelativeLocation, RelativeRotation);
+		return;
+	}
+
+	// Get the helicopter's body mesh (if it exists)
+	UStaticMeshComponent* HelicopterBody = Cast<UStaticMeshComponent>(GetOwner()->GetRootComponent());
+	if (!HelicopterBody) return;
+
 	// Get the current relative rotation
 	FRotator CurrentRotation = HelicopterBody->GetRelativeRotation();
 
@@ -325,54 +593,72 @@ void UHelicopterMoverComponent::ApplyBodyTilt(float DeltaTime)
 	//UE_LOG(LogTemp, Log, TEXT("Tilt - Pitch: %f, Roll: %f"), TargetPitch, TargetRoll);
 }
 
-void UHelicopterMoverComponent::CorrectClientState()
+void UHelicopterMoverComponent::SetVisualComponent(USceneComponent* InVisualComponent)
 {
-	// Interpolate to the server's authoritative state
-	FVector CurrentPosition = GetOwner()->GetActorLocation();
-	FRotator CurrentRotation = GetOwner()->GetActorRotation();
+	VisualComponent = InVisualComponent;
+	VisualBaseTransform = VisualComponent ? VisualComponent->GetRelativeTransform() : FTransform::Identity;
+	ResetVisualCorrection();
+}
 
-	// Correct position if the error is significant
-	if (!CurrentPosition.Equals(ServerState.Position, PositionErrorThreshold))
-	{
-		FHitResult HitResult;
-		FVector End = ServerState.Position;
-
-		FCollisionShape CollisionShape = FCollisionShape::MakeSphere(CollisionSphere); // Adjust as necessary
-		bool bHit = GetWorld()->SweepSingleByChannel(
-			HitResult,
-			CurrentPosition,
-			End,
-			FQuat::Identity,
-			ECC_WorldStatic,
-			CollisionShape,
-			FCollisionQueryParams(FName(TEXT("CorrectSweep")), true, GetOwner())
-		);
-
-		if (bHit && HitResult.IsValidBlockingHit())
-		{
-			HandleCollision(HitResult, GetWorld()->DeltaTimeSeconds);
-		}
-		else
-		{
-			// Smooth position correction
-			FVector InterpolatedPosition = FMath::VInterpTo(CurrentPosition, ServerState.Position, GetWorld()->DeltaTimeSeconds, CorrectionInterpolation);
-			GetOwner()->SetActorLocation(InterpolatedPosition, true);
-		}
-	}
-	
-	// Correct rotation if the error is significant
-	if (!CurrentRotation.Equals(ServerState.Rotation, RotationErrorThreshold))
+bool UHelicopterMoverComponent::HasVisualOffsetComponent() const
+{
+	return VisualComponent && GetOwner() && VisualComponent != GetOwner()->GetRootComponent();
+}
+
+void UHelicopterMoverComponent::AddVisualCorrection(const FTransform& PreviousTransform)
+{
+	if (!HasVisualOffsetComponent()) return;
+
+	// Leave the mesh where it was drawn and let the offset fade, the collision root is already at the corrected state
+	const FVector LocationError = PreviousTransform.GetLocation() - GetOwner()->GetActorLocation() + VisualLocationOffset;
+	if (LocationError.SizeSquared() > FMath::Square(MaxVisualCorrectionDistance))
 	{
-		FRotator InterpolatedRotation = FMath::RInterpTo(CurrentRotation, ServerState.Rotation, GetWorld()->DeltaTimeSeconds, CorrectionInterpolation);
-		GetOwner()->SetActorRotation(InterpolatedRotation);
+		ResetVisualCorrection();
+		return;
 	}
 
-	/*
-	// Only correct velocity if there's a large discrepancy
-	if (!CurrentVelocity.Equals(ServerState.Velocity, PositionErrorThreshold))
+	VisualLocationOffset = LocationError;
+	VisualRotationOffset = VisualRotationOffset * PreviousTransform.GetRotation() * GetOwner()->GetActorQuat().Inverse();
+	VisualRotationOffset.Normalize();
+}
+
+void UHelicopterMoverComponent::DecayVisualCorrection(float DeltaTime)
+{
+	if (VisualCorrectionHalfLife <= 0.0f)
 	{
-		CurrentVelocity = FMath::VInterpTo(CurrentVelocity, ServerState.Velocity, GetWorld()->DeltaTimeSeconds, CorrectionInterpolation);
+		ResetVisualCorrection();
+		return;
 	}
-	*/
 
+	// Exponential decay by half life, so the fade takes the same time whatever the frame rate
+	const float Remaining = FMath::Exp2(-DeltaTime / VisualCorrectionHalfLife);
+	VisualLocationOffset *= Remaining;
+	VisualRotationOffset = FQuat::Slerp(FQuat::Identity, VisualRotationOffset, Remaining);
+}
+
+void UHelicopterMoverComponent::ResetVisualCorrection()
+{
+	VisualLocationOffset = FVector::ZeroVector;
+	VisualRotationOffset = FQuat::Identity;
+}
+
+void UHelicopterMoverComponent::CorrectClientState()
+{
+	// The owning client corrects and replays its outstanding predictions in ReconcileState, this covers everyone else
+	if (PredictedStates.Num() > 0) return;
+
+	const FTransform PreviousTransform = GetOwner()->GetActorTransform();
+	const bool bPositionError = !PreviousTransform.GetLocation().Equals(ServerState.Position, PositionErrorThreshold);
+	const bool bRotationError = !GetOwner()->GetActorRotation().Equals(ServerState.Rotation, RotationErrorThreshold);
+	if (!bPositionError && !bRotationError) return;
+
+	UHelicopterTelemetrySubsystem::RecordCorrection(this, ServerState.Position - PreviousTransform.GetLocation());
+
+	// Snap the simulation to the server's authoritative state without a sweep, the server already resolved the collision
+	GetOwner()->SetActorLocationAndRotation(
+		bPositionError ? ServerState.Position : PreviousTransform.GetLocation(),
+		bRotationError ? ServerState.Rotation : GetOwner()->GetActorRotation(),
+		false, nullptr, ETeleportType::TeleportPhysics);
+
+	AddVisualCorrection(PreviousTransform);
 }
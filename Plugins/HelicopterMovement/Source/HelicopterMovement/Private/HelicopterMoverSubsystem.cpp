@@ -0,0 +1,301 @@
+#include "HelicopterMoverSubsystem.h"
+#include "HelicopterMovement.h"
+#include "HelicopterMoverComponent.h"
+#include "HelicopterBasePawn.h"
+#include "HelicopterAsyncPhysicsCallback.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Mover Subsystem Tick"), STAT_HelicopterMoverSubsystemTick, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Parallel Integrate And Sweep"), STAT_HelicopterParallelIntegrate, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Commit Moves"), STAT_HelicopterCommitMoves, STATGROUP_HelicopterMovement);
+DECLARE_CYCLE_STAT(TEXT("Async Physics Commit"), STAT_HelicopterAsyncCommit, STATGROUP_HelicopterMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Physics Movers"), STAT_HelicopterAsyncMovers, STATGROUP_HelicopterMovement);
+
+static TAutoConsoleVariable<int32> CVarHelicopterParallelMovement(
+	TEXT("heli.ParallelMovement"),
+	0,
+	TEXT("When non-zero, authoritative helicopter movers are integrated and swept in parallel on task graph workers.\n")
+	TEXT("Only the final transform commit runs on the game thread."),
+	ECVF_Default);
+
+void UHelicopterMoverSubsystem::Deinitialize()
+{
+	if (AsyncCallback)
+	{
+		FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+		if (Chaos::FPhysicsSolver* Solver = PhysScene ? PhysScene->GetSolver() : nullptr)
+		{
+			Solver->UnregisterAndFreeSimCallbackObject_External(AsyncCallback);
+		}
+		AsyncCallback = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+bool UHelicopterMoverSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHelicopterMoverSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterMoverSubsystemTick);
+	FHelicopterMoverCycleScope MoverCycleScope;
+
+	AuthorityMovers.Reset();
+	AsyncMovers.Reset();
+	for (UHelicopterMoverComponent* Mover : Movers)
+	{
+		if (IsValid(Mover) && IsDrivingMover(Mover) && Mover->IsComponentTickEnabled())
+		{
+			(UsesAsyncPhysics(Mover) ? AsyncMovers : AuthorityMovers).Add(Mover);
+		}
+	}
+
+	// Sleeping movers are left out, so the physics thread drops them until they wake
+	if (AsyncCallback)
+	{
+		StepAsyncMovers(AsyncMovers, DeltaTime);
+	}
+
+	StepMovers(AuthorityMovers, DeltaTime, 0);
+}
+
+bool UHelicopterMoverSubsystem::IsTickable() const
+{
+	return (IsParallelMovementEnabled() || AsyncCallback) && Movers.Num() > 0;
+}
+
+TStatId UHelicopterMoverSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHelicopterMoverSubsystem, STATGROUP_Tickables);
+}
+
+void UHelicopterMoverSubsystem::RegisterMover(UHelicopterMoverComponent* Mover)
+{
+	Movers.AddUnique(Mover);
+
+	if (Mover->bUseAsyncPhysics && Mover->GetOwner()->HasAuthority() && EnsureAsyncCallback())
+	{
+		Mover->AsyncPhysicsId = NextAsyncPhysicsId++;
+	}
+}
+
+void UHelicopterMoverSubsystem::UnregisterMover(UHelicopterMoverComponent* Mover)
+{
+	Movers.RemoveSwap(Mover);
+
+	if (AsyncCallback && Mover->AsyncPhysicsId != INDEX_NONE)
+	{
+		AsyncCallback->ForgetMover_External(Mover->AsyncPhysicsId);
+		Mover->AsyncPhysicsId = INDEX_NONE;
+	}
+}
+
+bool UHelicopterMoverSubsystem::IsDrivingMover(const UHelicopterMoverComponent* Mover) const
+{
+	if (!Mover->GetOwner() || !Mover->GetOwner()->HasAuthority()) return false;
+
+	return IsParallelMovementEnabled() || UsesAsyncPhysics(Mover);
+}
+
+bool UHelicopterMoverSubsystem::UsesAsyncPhysics(const UHelicopterMoverComponent* Mover) const
+{
+	return AsyncCallback && Mover->AsyncPhysicsId != INDEX_NONE;
+}
+
+bool UHelicopterMoverSubsystem::EnsureAsyncCallback()
+{
+	if (AsyncCallback) return true;
+
+	FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+	Chaos::FPhysicsSolver* Solver = PhysScene ? PhysScene->GetSolver() : nullptr;
+	if (!Solver)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("No Chaos solver in %s, async physics helicopters fall back to the game thread"), *GetWorld()->GetName());
+		return false;
+	}
+
+	// Without Tick Physics Async the callback runs on the game thread with the frame's variable delta time
+	UE_CLOG(!UPhysicsSettings::Get()->bTickPhysicsAsync, LogHelicopterMovement, Warning,
+		TEXT("Async physics helicopters need Tick Physics Async enabled in the project's physics settings, they are stepped on the game thread until it is"));
+	AsyncCallback = Solver->CreateAndRegisterSimCallbackObject_External<FHelicopterAsyncPhysicsCallback>();
+	return true;
+}
+
+void UHelicopterMoverSubsystem::StepAsyncMovers(TArrayView<UHelicopterMoverComponent* const> InMovers, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterAsyncCommit);
+	SET_DWORD_STAT(STAT_HelicopterAsyncMovers, InMovers.Num());
+
+	AsyncCallback->ConsumeOutputs_External();
+
+	TArray<FHelicopterAsyncMoverInput> Inputs;
+	Inputs.Reserve(InMovers.Num());
+	uint64 NumSweeps = 0;
+
+	for (UHelicopterMoverComponent* Mover : InMovers)
+	{
+		// Results simulated from a state that has since been replaced are dropped, the physics thread is about to restart it
+		const FHelicopterAsyncMoverState* State = AsyncCallback->FindLatestState_External(Mover->AsyncPhysicsId);
+		if (State && State->StateVersion == Mover->AsyncStateVersion)
+		{
+			FHelicopterMove Move;
+			Move.Start = Mover->GetOwner()->GetActorLocation();
+			Move.End = State->Position;
+			Move.Rotation = State->Rotation;
+			Mover->CurrentVelocity = State->Velocity;
+			Mover->CurrentYawSpeed = State->YawSpeed;
+
+			// The physics thread only integrates, collision is still resolved here against the game thread scene
+			Mover->SweepMove(Move);
+			Mover->CommitMove(Move, DeltaTime);
+			NumSweeps++;
+
+			if (Move.bHit && Move.HitResult.IsValidBlockingHit())
+			{
+				Mover->AsyncStateVersion++;
+			}
+		}
+
+		FHelicopterAsyncMoverInput& Input = Inputs.AddDefaulted_GetRef();
+		Input.State.Id = Mover->AsyncPhysicsId;
+		Input.State.StateVersion = Mover->AsyncStateVersion;
+		Input.State.Position = Mover->GetOwner()->GetActorLocation();
+		Input.State.Rotation = Mover->GetOwner()->GetActorRotation();
+		Input.State.Velocity = Mover->CurrentVelocity;
+		Input.State.YawSpeed = Mover->CurrentYawSpeed;
+		Input.DesiredInput = Mover->DesiredInput;
+		Input.DesiredYawInput = Mover->DesiredYawInput;
+		Input.Params = Mover->GetFlightParams();
+	}
+
+	FHelicopterMovementCounters::CountSweeps(NumSweeps);
+	AsyncCallback->PushInputs_External(Inputs);
+}
+
+void UHelicopterMoverSubsystem::StepMovers(TArrayView<UHelicopterMoverComponent* const> InMovers, float DeltaTime, int32 NumTasks)
+{
+	const int32 NumMovers = InMovers.Num();
+	if (NumMovers == 0) return;
+
+	TArray<FHelicopterMove> Moves;
+	Moves.SetNum(NumMovers);
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HelicopterParallelIntegrate);
+
+		// A task count of zero lets the task graph pick the batching, otherwise work is split into exactly NumTasks chunks
+		const int32 NumChunks = NumTasks > 0 ? FMath::Min(NumTasks, NumMovers) : NumMovers;
+		const int32 ChunkSize = FMath::DivideAndRoundUp(NumMovers, NumChunks);
+
+		ParallelFor(NumChunks, [&](int32 ChunkIndex)
+		{
+			const int32 First = ChunkIndex * ChunkSize;
+			const int32 Last = FMath::Min(First + ChunkSize, NumMovers);
+			for (int32 Index = First; Index < Last; Index++)
+			{
+				InMovers[Index]->PrepareMove(DeltaTime, Moves[Index]);
+				InMovers[Index]->SweepMove(Moves[Index]);
+			}
+			FHelicopterMovementCounters::CountSweeps(Last - First);
+		}, NumChunks == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HelicopterCommitMoves);
+
+		// Moving actors updates overlaps and the scene, so the commit stays on the game thread
+		for (int32 Index = 0; Index < NumMovers; Index++)
+		{
+			InMovers[Index]->CommitMove(Moves[Index], DeltaTime);
+		}
+	}
+}
+
+bool UHelicopterMoverSubsystem::IsParallelMovementEnabled()
+{
+	return CVarHelicopterParallelMovement.GetValueOnGameThread() != 0;
+}
+
+/* Spawns helicopters on a grid in open air so the sweeps are representative but independent */
+static TArray<AHelicopterBasePawn*> SpawnBenchmarkHelicopters(UWorld* World, int32 NumHelicopters)
+{
+	TArray<AHelicopterBasePawn*> Helicopters;
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumHelicopters)));
+
+	for (int32 Index = 0; Index < NumHelicopters; Index++)
+	{
+		const FTransform SpawnTransform(FVector((Index % GridSize) * 1000.0f, (Index / GridSize) * 1000.0f, 5000.0f));
+		AHelicopterBasePawn* Helicopter = World->SpawnActorDeferred<AHelicopterBasePawn>(AHelicopterBasePawn::StaticClass(), SpawnTransform,
+			nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		if (!Helicopter) continue;
+
+		if (Helicopter->HelicopterMover)
+		{
+			Helicopter->HelicopterMover->DesiredInput = FVector(1.0f, 0.5f, 0.1f);
+			Helicopter->HelicopterMover->DesiredYawInput = 0.5f;
+		}
+
+		Helicopter->FinishSpawning(SpawnTransform);
+		Helicopters.Add(Helicopter);
+	}
+
+	return Helicopters;
+}
+
+/* * * Scaling benchmark: heli.BenchmarkParallelMovement [NumHelicopters] [NumIterations] * * */
+static FAutoConsoleCommandWithWorldAndArgs GHelicopterBenchmarkParallelMovementCmd(
+	TEXT("heli.BenchmarkParallelMovement"),
+	TEXT("Spawns helicopters and times the batched movement step with 1, 2, 4 and 8 worker tasks.\n")
+	TEXT("Usage: heli.BenchmarkParallelMovement [NumHelicopters=256] [NumIterations=100]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client)
+		{
+			UE_LOG(LogHelicopterMovement, Warning, TEXT("heli.BenchmarkParallelMovement must run on a world with authority"));
+			return;
+		}
+
+		const int32 NumHelicopters = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 256;
+		const int32 NumIterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100;
+		const float DeltaTime = 1.0f / 60.0f;
+
+		TArray<AHelicopterBasePawn*> Helicopters = SpawnBenchmarkHelicopters(World, NumHelicopters);
+		TArray<UHelicopterMoverComponent*> BenchmarkMovers;
+		for (AHelicopterBasePawn* Helicopter : Helicopters)
+		{
+			if (Helicopter->HelicopterMover)
+			{
+				BenchmarkMovers.Add(Helicopter->HelicopterMover);
+			}
+		}
+
+		UE_LOG(LogHelicopterMovement, Log, TEXT("Parallel movement benchmark: %d helicopters, %d iterations, %d task graph workers"),
+			BenchmarkMovers.Num(), NumIterations, FTaskGraphInterface::Get().GetNumWorkerThreads());
+
+		for (const int32 NumTasks : { 1, 2, 4, 8 })
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+			{
+				UHelicopterMoverSubsystem::StepMovers(BenchmarkMovers, DeltaTime, NumTasks);
+			}
+			const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			UE_LOG(LogHelicopterMovement, Log, TEXT("  %d task(s): %.3f ms per step, %.2f us per helicopter"),
+				NumTasks, ElapsedMs / NumIterations, ElapsedMs * 1000.0 / (NumIterations * FMath::Max(1, BenchmarkMovers.Num())));
+		}
+
+		for (AHelicopterBasePawn* Helicopter : Helicopters)
+		{
+			Helicopter->Destroy();
+		}
+	}));
@@ -0,0 +1,280 @@
+#include "HelicopterReplicationGraph.h"
+#include "HelicopterMovement.h"
+#include "HelicopterBasePawn.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GenericTeamAgentInterface.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Helicopter Relevancy Gather"), STAT_HelicopterRelevancyGather, STATGROUP_HelicopterMovement);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Replicate Actors (ms)"), STAT_HelicopterReplicateActorsMs, STATGROUP_HelicopterMovement);
+
+void UReplicationGraphNode_HelicopterPolicy::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterRelevancyGather);
+
+	GatheredHelicopters.Reset(Graph->GetHelicopters().Num());
+	LastGatheredCount = 0;
+	LastCulledCount = 0;
+
+	for (FActorRepListType Actor : Graph->GetHelicopters())
+	{
+		const AHelicopterBasePawn* Helicopter = static_cast<const AHelicopterBasePawn*>(Actor);
+
+		// Use the most frequent period any of the connection's viewers asks for, zero means every viewer culls it
+		int32 ReplicationPeriod = 0;
+		for (const FNetViewer& Viewer : Params.Viewers)
+		{
+			if (Viewer.ViewTarget == Helicopter || Viewer.InViewer == Helicopter->GetController()
+				|| UHelicopterReplicationGraph::IsOccupiedByViewerTeam(Helicopter, Viewer.InViewer))
+			{
+				ReplicationPeriod = 1;
+				break;
+			}
+
+			const FVector ToHelicopter = Helicopter->GetActorLocation() - Viewer.ViewLocation;
+			const int32 ViewerPeriod = Graph->GetHelicopterReplicationPeriod(ToHelicopter.Size(), ToHelicopter.Z);
+			if (ViewerPeriod > 0 && (ReplicationPeriod == 0 || ViewerPeriod < ReplicationPeriod))
+			{
+				ReplicationPeriod = ViewerPeriod;
+			}
+		}
+
+		if (ReplicationPeriod == 0)
+		{
+			LastCulledCount++;
+			continue;
+		}
+
+		// Always gathered so the channel stays open, the connection's own period decides how often it is actually sent
+		FConnectionReplicationActorInfo& ConnectionInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(Actor);
+		ConnectionInfo.ReplicationPeriodFrame = static_cast<uint32>(ReplicationPeriod);
+
+		GatheredHelicopters.Add(Actor);
+		LastGatheredCount++;
+	}
+
+	if (GatheredHelicopters.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(GatheredHelicopters);
+	}
+}
+
+UHelicopterReplicationGraph::UHelicopterReplicationGraph()
+{
+	GridCellSize = 10000.0f;
+	HelicopterBaseCullDistance = 15000.0f;
+	HelicopterAltitudeCullScale = 4.0f;
+	HelicopterMaxCullDistance = 60000.0f;
+
+	FrequencyBuckets = {
+		{ 8000.0f, 1 },
+		{ 20000.0f, 3 },
+		{ 40000.0f, 6 }
+	};
+}
+
+void UHelicopterReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Everything else replicates at its own frequency and cull distance, the same as without a graph
+	const AActor* ActorDefaults = GetDefault<AActor>();
+	FClassReplicationInfo DefaultInfo;
+	DefaultInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorDefaults->NetUpdateFrequency);
+	DefaultInfo.SetCullDistanceSquared(ActorDefaults->NetCullDistanceSquared);
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), DefaultInfo);
+
+	// Helicopters are culled and throttled per viewer by the policy node, the class info only caps them at their own rate
+	FClassReplicationInfo HelicopterInfo;
+	HelicopterInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(GetDefault<AHelicopterBasePawn>()->NetUpdateFrequency);
+	HelicopterInfo.SetCullDistanceSquared(0.0f);
+	GlobalActorReplicationInfoMap.SetClassInfo(AHelicopterBasePawn::StaticClass(), HelicopterInfo);
+}
+
+void UHelicopterReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = FVector2D(-200000.0f, -200000.0f);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UHelicopterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// The viewer's own controller, pawn and view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnection = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnection, ConnectionManager);
+
+	UReplicationGraphNode_HelicopterPolicy* HelicopterNode = CreateNewNode<UReplicationGraphNode_HelicopterPolicy>();
+	HelicopterNode->Graph = this;
+	HelicopterNode->NetConnection = ConnectionManager->NetConnection;
+	AddConnectionGraphNode(HelicopterNode, ConnectionManager);
+	HelicopterNodes.Add(HelicopterNode);
+}
+
+void UHelicopterReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	// The connection's nodes go with it, stop the stats from walking them. Also drops any whose connection was already collected
+	HelicopterNodes.RemoveAllSwap([NetConnection](const UReplicationGraphNode_HelicopterPolicy* Node)
+	{
+		return !Node->NetConnection.IsValid() || Node->NetConnection.Get() == NetConnection;
+	});
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+void UHelicopterReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	if (Actor->IsA<AHelicopterBasePawn>())
+	{
+		Helicopters.Add(Actor);
+	}
+	else if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+	}
+	else if (!Actor->bOnlyRelevantToOwner)
+	{
+		// Owner only actors are picked up by the per connection always relevant node
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+	}
+}
+
+void UHelicopterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+
+	if (Actor->IsA<AHelicopterBasePawn>())
+	{
+		Helicopters.RemoveFast(Actor);
+	}
+	else if (Actor->bAlwaysRelevant)
+	{
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+	}
+	else if (!Actor->bOnlyRelevantToOwner)
+	{
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+	}
+}
+
+int32 UHelicopterReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	AverageReplicateMs = FMath::Lerp(AverageReplicateMs, ElapsedMs, 0.05);
+	SET_FLOAT_STAT(STAT_HelicopterReplicateActorsMs, ElapsedMs);
+
+	return Result;
+}
+
+float UHelicopterReplicationGraph::GetHelicopterCullDistance(float AltitudeAboveViewer) const
+{
+	// High helicopters stand out against the sky, so they stay relevant further away
+	return FMath::Min(HelicopterBaseCullDistance + FMath::Max(AltitudeAboveViewer, 0.0f) * HelicopterAltitudeCullScale, HelicopterMaxCullDistance);
+}
+
+int32 UHelicopterReplicationGraph::GetHelicopterReplicationPeriod(float Distance, float AltitudeAboveViewer) const
+{
+	if (Distance > GetHelicopterCullDistance(AltitudeAboveViewer)) return 0;
+
+	for (const FHelicopterFrequencyBucket& Bucket : FrequencyBuckets)
+	{
+		if (Distance <= Bucket.MaxDistance)
+		{
+			return FMath::Max(Bucket.ReplicationPeriodFrame, 1);
+		}
+	}
+	return FrequencyBuckets.Num() > 0 ? FMath::Max(FrequencyBuckets.Last().ReplicationPeriodFrame, 1) : 1;
+}
+
+bool UHelicopterReplicationGraph::IsOccupiedByViewerTeam(const AHelicopterBasePawn* Helicopter, const AActor* Viewer)
+{
+	const IGenericTeamAgentInterface* ViewerTeamAgent = Cast<const IGenericTeamAgentInterface>(Viewer);
+	if (!ViewerTeamAgent || ViewerTeamAgent->GetGenericTeamId() == FGenericTeamId::NoTeam) return false;
+
+	const IGenericTeamAgentInterface* PilotTeamAgent = Cast<const IGenericTeamAgentInterface>(Helicopter->GetController());
+	if (PilotTeamAgent && PilotTeamAgent->GetGenericTeamId() == ViewerTeamAgent->GetGenericTeamId()) return true;
+
+	// Passengers count too, through their controller when they are pawns
+	for (const FHelicopterSeatAssignment& Assignment : Helicopter->GetSeatAssignments())
+	{
+		const APawn* OccupantPawn = Cast<APawn>(Assignment.Occupant);
+		const AActor* TeamActor = OccupantPawn && OccupantPawn->GetController() ? OccupantPawn->GetController() : Assignment.Occupant.Get();
+		const IGenericTeamAgentInterface* OccupantTeamAgent = Cast<const IGenericTeamAgentInterface>(TeamActor);
+		if (OccupantTeamAgent && OccupantTeamAgent->GetGenericTeamId() == ViewerTeamAgent->GetGenericTeamId()) return true;
+	}
+	return false;
+}
+
+void UHelicopterReplicationGraph::AddSeatedOccupant(AHelicopterBasePawn* Helicopter, AActor* Occupant)
+{
+	// The graph captured the occupant's period when it was routed, a new NetUpdateFrequency alone is never read
+	SetActorReplicationPeriod(Occupant, GetReplicationPeriodFrameForFrequency(Occupant->NetUpdateFrequency));
+	GlobalActorReplicationInfoMap.AddDependentActor(Helicopter, Occupant);
+}
+
+void UHelicopterReplicationGraph::RemoveSeatedOccupant(AHelicopterBasePawn* Helicopter, AActor* Occupant)
+{
+	GlobalActorReplicationInfoMap.RemoveDependentActor(Helicopter, Occupant);
+	SetActorReplicationPeriod(Occupant, GlobalActorReplicationInfoMap.GetClassInfo(Occupant->GetClass()).ReplicationPeriodFrame);
+}
+
+void UHelicopterReplicationGraph::SetActorReplicationPeriod(AActor* Actor, uint32 ReplicationPeriodFrame)
+{
+	if (FGlobalActorReplicationInfo* GlobalInfo = GlobalActorReplicationInfoMap.Find(Actor))
+	{
+		GlobalInfo->Settings.ReplicationPeriodFrame = ReplicationPeriodFrame;
+	}
+
+	// Connection infos copy the period when they are created
+	for (UNetReplicationGraphConnection* Connection : Connections)
+	{
+		if (FConnectionReplicationActorInfo* ConnectionInfo = Connection->ActorInfoMap.Find(Actor))
+		{
+			ConnectionInfo->ReplicationPeriodFrame = ReplicationPeriodFrame;
+		}
+	}
+}
+
+void UHelicopterReplicationGraph::LogReplicationStats() const
+{
+	UE_LOG(LogHelicopterMovement, Log, TEXT("Helicopter replication: %.3f ms average ServerReplicateActors, %d helicopters, %d connections"),
+		AverageReplicateMs, Helicopters.Num(), HelicopterNodes.Num());
+
+	for (const UReplicationGraphNode_HelicopterPolicy* Node : HelicopterNodes)
+	{
+		const UNetConnection* Connection = Node->NetConnection.Get();
+		if (!Connection) continue;
+
+		UE_LOG(LogHelicopterMovement, Log, TEXT("  %s: %d bytes/s out, %d helicopters gathered and %d culled last gather"),
+			*Connection->LowLevelGetRemoteAddress(true), Connection->OutBytesPerSecond, Node->LastGatheredCount, Node->LastCulledCount);
+	}
+}
+
+static FAutoConsoleCommandWithWorld GHelicopterReplicationStatsCmd(
+	TEXT("heli.ReplicationStats"),
+	TEXT("Logs helicopter replication CPU time and per connection bandwidth on a server using the helicopter replication graph."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		const UHelicopterReplicationGraph* Graph = NetDriver ? NetDriver->GetReplicationDriver<UHelicopterReplicationGraph>() : nullptr;
+		if (!Graph)
+		{
+			UE_LOG(LogHelicopterMovement, Warning, TEXT("heli.ReplicationStats: no helicopter replication graph on this world's net driver"));
+			return;
+		}
+		Graph->LogReplicationStats();
+	}));
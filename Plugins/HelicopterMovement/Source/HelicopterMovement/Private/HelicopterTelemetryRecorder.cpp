@@ -0,0 +1,137 @@
+#include "HelicopterTelemetryRecorder.h"
+#include "HelicopterMovement.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+/* Roughly four seconds of 64 helicopters at 60Hz per thread, must be a power of two */
+static constexpr uint32 TelemetryBufferCapacity = 1 << 14;
+
+/* Records per chunk, a little over 300KB */
+static constexpr int32 TelemetryChunkRecords = 4096;
+
+/* How often the writer thread drains the buffers */
+static constexpr float TelemetryFlushInterval = 0.05f;
+
+static std::atomic<uint32> GNextTelemetrySessionId { 1 };
+
+/* Each recording thread caches its buffer, tagged with the recorder it belongs to */
+static thread_local FHelicopterTelemetryBuffer* GThreadTelemetryBuffer = nullptr;
+static thread_local uint32 GThreadTelemetrySessionId = 0;
+
+FHelicopterTelemetryRecorder::FHelicopterTelemetryRecorder(IFileHandle* InFileHandle)
+	: FileHandle(InFileHandle)
+	, SessionId(GNextTelemetrySessionId++)
+{
+	FHelicopterTelemetryFileHeader Header;
+	Header.StartUtcTicks = FDateTime::UtcNow().GetTicks();
+	FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+	PendingRecords.Reserve(TelemetryChunkRecords);
+	Thread = FRunnableThread::Create(this, TEXT("HelicopterTelemetryWriter"), 0, TPri_BelowNormal);
+}
+
+FHelicopterTelemetryRecorder::~FHelicopterTelemetryRecorder()
+{
+	Shutdown();
+}
+
+void FHelicopterTelemetryRecorder::Record(const FHelicopterTelemetryRecord& Record)
+{
+	FHelicopterTelemetryBuffer& Buffer = GetThreadBuffer();
+	if (!Buffer.Records.Enqueue(Record))
+	{
+		Buffer.NumDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+FHelicopterTelemetryBuffer& FHelicopterTelemetryRecorder::GetThreadBuffer()
+{
+	if (GThreadTelemetrySessionId != SessionId)
+	{
+		FScopeLock Lock(&BuffersLock);
+		GThreadTelemetryBuffer = Buffers.Add_GetRef(MakeUnique<FHelicopterTelemetryBuffer>(TelemetryBufferCapacity)).Get();
+		GThreadTelemetrySessionId = SessionId;
+	}
+	return *GThreadTelemetryBuffer;
+}
+
+void FHelicopterTelemetryRecorder::Shutdown()
+{
+	if (Thread)
+	{
+		// Waits for Run to return, which drains and writes whatever is left
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (FileHandle)
+	{
+		FileHandle->Flush();
+		FileHandle.Reset();
+	}
+}
+
+uint32 FHelicopterTelemetryRecorder::Run()
+{
+	while (!bStopRequested)
+	{
+		Drain();
+		FPlatformProcess::Sleep(TelemetryFlushInterval);
+	}
+
+	Drain();
+	if (PendingRecords.Num() > 0 || PendingDropped > 0)
+	{
+		WriteChunk();
+	}
+	return 0;
+}
+
+void FHelicopterTelemetryRecorder::Drain()
+{
+	// Copy the list so a thread registering its buffer never waits on the disk
+	{
+		FScopeLock Lock(&BuffersLock);
+		DrainBuffers.Reset(Buffers.Num());
+		for (const TUniquePtr<FHelicopterTelemetryBuffer>& Buffer : Buffers)
+		{
+			DrainBuffers.Add(Buffer.Get());
+		}
+	}
+
+	for (FHelicopterTelemetryBuffer* Buffer : DrainBuffers)
+	{
+		PendingDropped += Buffer->NumDropped.exchange(0, std::memory_order_relaxed);
+
+		FHelicopterTelemetryRecord Record;
+		while (Buffer->Records.Dequeue(Record))
+		{
+			PendingRecords.Add(Record);
+			if (PendingRecords.Num() >= TelemetryChunkRecords)
+			{
+				WriteChunk();
+			}
+		}
+	}
+}
+
+void FHelicopterTelemetryRecorder::WriteChunk()
+{
+	FHelicopterTelemetryChunkHeader Header;
+	Header.NumRecords = PendingRecords.Num();
+	Header.NumDropped = PendingDropped;
+
+	FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	FileHandle->Write(reinterpret_cast<const uint8*>(PendingRecords.GetData()), PendingRecords.Num() * sizeof(FHelicopterTelemetryRecord));
+
+	if (PendingDropped > 0)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Helicopter telemetry dropped %u records, the ring buffers filled faster than they were flushed"), PendingDropped);
+	}
+
+	PendingRecords.Reset();
+	PendingDropped = 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/CircularQueue.h"
+#include "HelicopterTelemetrySubsystem.h"
+#include <atomic>
+
+/* Forward Declarations */
+class FRunnableThread;
+class IFileHandle;
+
+/* * * Single producer ring buffer owned by one recording thread * * */
+struct FHelicopterTelemetryBuffer
+{
+	explicit FHelicopterTelemetryBuffer(uint32 Capacity) : Records(Capacity) { }
+
+	TCircularQueue<FHelicopterTelemetryRecord> Records;
+	std::atomic<uint32> NumDropped { 0 };
+};
+
+/* * * Owns the ring buffers and the background thread that writes them to disk * * */
+class FHelicopterTelemetryRecorder : public FRunnable
+{
+public:
+	explicit FHelicopterTelemetryRecorder(IFileHandle* InFileHandle);
+	virtual ~FHelicopterTelemetryRecorder() override;
+
+	/* Callable from any thread, drops the record if this thread's buffer is full */
+	void Record(const FHelicopterTelemetryRecord& Record);
+
+	/* Writes everything still buffered and closes the file, only once no thread is recording any more */
+	void Shutdown();
+
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested = true; }
+
+private:
+	FHelicopterTelemetryBuffer& GetThreadBuffer();
+	void Drain();
+	void WriteChunk();
+
+	TUniquePtr<IFileHandle> FileHandle;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopRequested { false };
+
+	/* Identifies this recorder in each thread's cached buffer pointer */
+	uint32 SessionId;
+
+	/* Held only to register a buffer or to copy the list, never across file writes. Buffers live as long as the recorder */
+	FCriticalSection BuffersLock;
+	TArray<TUniquePtr<FHelicopterTelemetryBuffer>> Buffers;
+
+	/* Only touched by the writer thread */
+	TArray<FHelicopterTelemetryBuffer*> DrainBuffers;
+	TArray<FHelicopterTelemetryRecord> PendingRecords;
+	uint32 PendingDropped = 0;
+};
@@ -0,0 +1,288 @@
+#include "HelicopterTelemetrySubsystem.h"
+#include "HelicopterTelemetryRecorder.h"
+#include "HelicopterMovement.h"
+#include "HelicopterMoverComponent.h"
+#include "HelicopterMoverSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+DECLARE_CYCLE_STAT(TEXT("Telemetry Record"), STAT_HelicopterTelemetryRecord, STATGROUP_HelicopterMovement);
+
+/* Set while a recording is running, Start and Stop happen on the game thread between frames */
+static std::atomic<FHelicopterTelemetryRecorder*> GTelemetryRecorder { nullptr };
+
+/* Ids start at one so a zero in a file means the mover never began play */
+static std::atomic<uint32> GNextTelemetryHelicopterId { 1 };
+
+/* Game thread cost of the state records and the server time they covered, logged when the recording stops */
+static uint64 GTelemetryTickCycles = 0;
+static double GTelemetryRecordedSeconds = 0.0;
+
+/* Threads currently holding the recorder, StopRecording waits for this to reach zero before freeing it */
+static std::atomic<int32> GTelemetryProducers { 0 };
+
+/* Pins the current recorder for worker and physics thread producers */
+struct FHelicopterTelemetryProducerScope
+{
+	FHelicopterTelemetryProducerScope()
+	{
+		// Sequentially consistent with the exchange in StopRecording, either we see null or it sees us
+		GTelemetryProducers.fetch_add(1);
+		Recorder = GTelemetryRecorder.load();
+	}
+
+	~FHelicopterTelemetryProducerScope()
+	{
+		GTelemetryProducers.fetch_sub(1);
+	}
+
+	FHelicopterTelemetryRecorder* Recorder;
+};
+
+static FHelicopterTelemetryRecord MakeTelemetryRecord(const UHelicopterMoverComponent* Mover, ETelemetry_Record Type)
+{
+	const AActor* Owner = Mover->GetOwner();
+
+	FHelicopterTelemetryRecord Record;
+	Record.Time = Mover->GetWorld()->GetTimeSeconds();
+	Record.HelicopterId = Mover->GetTelemetryId();
+	Record.Type = Type;
+	Record.NetMode = static_cast<uint8>(Owner->GetNetMode());
+	Record.Position = FVector3f(Owner->GetActorLocation());
+	Record.Rotation = FRotator3f(Owner->GetActorRotation());
+	Record.Velocity = FVector3f(Mover->GetCurrentVelocity());
+	Record.Input = FVector3f(Mover->DesiredInput);
+	Record.YawInput = Mover->DesiredYawInput;
+	return Record;
+}
+
+bool UHelicopterTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHelicopterTelemetrySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_HelicopterTelemetryRecord);
+
+	// Client worlds only hold predictions and replicated copies, PIE would otherwise mix them into the server's file
+	FHelicopterTelemetryRecorder* Recorder = GTelemetryRecorder.load(std::memory_order_acquire);
+	const UHelicopterMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UHelicopterMoverSubsystem>();
+	if (!Recorder || !MoverSubsystem || GetWorld()->GetNetMode() == NM_Client) return;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Sleeping helicopters have nothing new to say
+	for (const UHelicopterMoverComponent* Mover : MoverSubsystem->GetMovers())
+	{
+		if (IsValid(Mover) && Mover->IsComponentTickEnabled())
+		{
+			Recorder->Record(MakeTelemetryRecord(Mover, ETelemetry_Record::ETR_State));
+		}
+	}
+
+	GTelemetryTickCycles += FPlatformTime::Cycles64() - StartCycles;
+	GTelemetryRecordedSeconds += DeltaTime;
+}
+
+bool UHelicopterTelemetrySubsystem::IsTickable() const
+{
+	return IsRecording();
+}
+
+TStatId UHelicopterTelemetrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHelicopterTelemetrySubsystem, STATGROUP_Tickables);
+}
+
+bool UHelicopterTelemetrySubsystem::StartRecording(const FString& FilePath)
+{
+	StopRecording();
+
+	IFileHandle* FileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath);
+	if (!FileHandle)
+	{
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+		FileHandle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath);
+	}
+	if (!FileHandle)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Could not open %s for helicopter telemetry"), *FilePath);
+		return false;
+	}
+
+	GTelemetryTickCycles = 0;
+	GTelemetryRecordedSeconds = 0.0;
+	GTelemetryRecorder.store(new FHelicopterTelemetryRecorder(FileHandle), std::memory_order_release);
+	UE_LOG(LogHelicopterMovement, Log, TEXT("Recording helicopter telemetry to %s"), *FilePath);
+	return true;
+}
+
+void UHelicopterTelemetrySubsystem::StopRecording()
+{
+	if (FHelicopterTelemetryRecorder* Recorder = GTelemetryRecorder.exchange(nullptr))
+	{
+		// A worker may have loaded the recorder just before the exchange, let it finish its record
+		while (GTelemetryProducers.load() > 0)
+		{
+			FPlatformProcess::Yield();
+		}
+
+		Recorder->Shutdown();
+		delete Recorder;
+		const double TickMs = FPlatformTime::ToMilliseconds64(GTelemetryTickCycles);
+		UE_LOG(LogHelicopterMovement, Log, TEXT("Stopped recording helicopter telemetry, state records cost %.3f ms over %.1f s of play (%.3f%% of frame time)"),
+			TickMs, GTelemetryRecordedSeconds, GTelemetryRecordedSeconds > 0.0 ? TickMs / (GTelemetryRecordedSeconds * 10.0) : 0.0);
+	}
+}
+
+bool UHelicopterTelemetrySubsystem::IsRecording()
+{
+	return GTelemetryRecorder.load(std::memory_order_relaxed) != nullptr;
+}
+
+uint32 UHelicopterTelemetrySubsystem::MakeHelicopterId()
+{
+	return GNextTelemetryHelicopterId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UHelicopterTelemetrySubsystem::RecordCorrection(const UHelicopterMoverComponent* Mover, const FVector& PositionError)
+{
+	const FHelicopterTelemetryProducerScope Producer;
+	if (Producer.Recorder)
+	{
+		FHelicopterTelemetryRecord Record = MakeTelemetryRecord(Mover, ETelemetry_Record::ETR_Correction);
+		Record.Detail = FVector3f(PositionError);
+		Producer.Recorder->Record(Record);
+	}
+}
+
+void UHelicopterTelemetrySubsystem::RecordSweepHit(const UHelicopterMoverComponent* Mover, const FHitResult& HitResult)
+{
+	const FHelicopterTelemetryProducerScope Producer;
+	if (Producer.Recorder)
+	{
+		FHelicopterTelemetryRecord Record = MakeTelemetryRecord(Mover, ETelemetry_Record::ETR_SweepHit);
+		Record.Detail = FVector3f(HitResult.ImpactNormal);
+		Producer.Recorder->Record(Record);
+	}
+}
+
+bool UHelicopterTelemetrySubsystem::ExportCsv(const FString& InFilePath, const FString& OutFilePath)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InFilePath));
+	if (!Reader)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Could not open helicopter telemetry file %s"), *InFilePath);
+		return false;
+	}
+
+	FHelicopterTelemetryFileHeader Header;
+	Reader->Serialize(&Header, sizeof(Header));
+	if (Header.Magic != FHelicopterTelemetryFileHeader::ExpectedMagic || Header.Version == 0 || Header.Version > FHelicopterTelemetryFileHeader::CurrentVersion
+		|| Header.RecordSize != sizeof(FHelicopterTelemetryRecord))
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("%s is not a helicopter telemetry file this build can read"), *InFilePath);
+		return false;
+	}
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*OutFilePath));
+	if (!Writer)
+	{
+		UE_LOG(LogHelicopterMovement, Warning, TEXT("Could not open %s for writing"), *OutFilePath);
+		return false;
+	}
+
+	static const TCHAR* TypeNames[] = { TEXT("State"), TEXT("Correction"), TEXT("SweepHit") };
+	static_assert(UE_ARRAY_COUNT(TypeNames) == static_cast<int32>(ETelemetry_Record::ETR_Max), "Every record type needs a name");
+
+	// Version 1 files left this byte as padding, which reads back as standalone
+	static const TCHAR* NetModeNames[] = { TEXT("Standalone"), TEXT("DedicatedServer"), TEXT("ListenServer"), TEXT("Client") };
+	static_assert(UE_ARRAY_COUNT(NetModeNames) == NM_MAX, "Every net mode needs a name");
+
+	const ANSICHAR* CsvHeader = "Time,HelicopterId,Type,NetMode,PosX,PosY,PosZ,Pitch,Yaw,Roll,VelX,VelY,VelZ,InputX,InputY,InputZ,YawInput,DetailX,DetailY,DetailZ\n";
+	Writer->Serialize(const_cast<ANSICHAR*>(CsvHeader), FCStringAnsi::Strlen(CsvHeader));
+
+	FString Csv;
+	int64 NumRecords = 0;
+	int64 NumDropped = 0;
+
+	TArray<FHelicopterTelemetryRecord> Records;
+	while (Reader->Tell() + static_cast<int64>(sizeof(FHelicopterTelemetryChunkHeader)) <= Reader->TotalSize())
+	{
+		FHelicopterTelemetryChunkHeader Chunk;
+		Reader->Serialize(&Chunk, sizeof(Chunk));
+		if (Chunk.Magic != FHelicopterTelemetryChunkHeader::ExpectedMagic)
+		{
+			UE_LOG(LogHelicopterMovement, Warning, TEXT("Corrupt chunk at offset %lld in %s, stopping"), Reader->Tell() - sizeof(Chunk), *InFilePath);
+			break;
+		}
+
+		// A recording cut short by a crash can end part way through its last chunk
+		const int64 Available = (Reader->TotalSize() - Reader->Tell()) / sizeof(FHelicopterTelemetryRecord);
+		Records.SetNumUninitialized(FMath::Min<int64>(Chunk.NumRecords, Available));
+		Reader->Serialize(Records.GetData(), Records.Num() * sizeof(FHelicopterTelemetryRecord));
+		NumDropped += Chunk.NumDropped;
+
+		for (const FHelicopterTelemetryRecord& Record : Records)
+		{
+			const int32 TypeIndex = FMath::Min(static_cast<int32>(Record.Type), static_cast<int32>(ETelemetry_Record::ETR_Max) - 1);
+			const int32 NetModeIndex = FMath::Min(static_cast<int32>(Record.NetMode), NM_MAX - 1);
+			Csv += FString::Printf(TEXT("%.4f,%u,%s,%s,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.1f,%.1f,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+				Record.Time, Record.HelicopterId, TypeNames[TypeIndex], NetModeNames[NetModeIndex],
+				Record.Position.X, Record.Position.Y, Record.Position.Z,
+				Record.Rotation.Pitch, Record.Rotation.Yaw, Record.Rotation.Roll,
+				Record.Velocity.X, Record.Velocity.Y, Record.Velocity.Z,
+				Record.Input.X, Record.Input.Y, Record.Input.Z, Record.YawInput,
+				Record.Detail.X, Record.Detail.Y, Record.Detail.Z);
+		}
+		NumRecords += Records.Num();
+
+		// Write a chunk at a time so large recordings do not build one huge string
+		const FTCHARToUTF8 Utf8(*Csv);
+		Writer->Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+		Csv.Reset();
+	}
+
+	UE_LOG(LogHelicopterMovement, Log, TEXT("Exported %lld helicopter telemetry records to %s, %lld were dropped while recording"), NumRecords, *OutFilePath, NumDropped);
+	return true;
+}
+
+static FAutoConsoleCommand GHelicopterTelemetryStartCmd(
+	TEXT("heli.Telemetry.Start"),
+	TEXT("Starts recording helicopter flight telemetry.\n")
+	TEXT("Usage: heli.Telemetry.Start [FilePath=Saved/Telemetry/Helicopters_<Time>.hfr]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString FilePath = Args.Num() > 0 ? Args[0]
+			: FPaths::ProjectSavedDir() / TEXT("Telemetry") / FString::Printf(TEXT("Helicopters_%s.hfr"), *FDateTime::Now().ToString());
+		UHelicopterTelemetrySubsystem::StartRecording(FilePath);
+	}));
+
+static FAutoConsoleCommand GHelicopterTelemetryStopCmd(
+	TEXT("heli.Telemetry.Stop"),
+	TEXT("Flushes and closes the current helicopter telemetry recording."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		UHelicopterTelemetrySubsystem::StopRecording();
+	}));
+
+static FAutoConsoleCommand GHelicopterTelemetryExportCmd(
+	TEXT("heli.Telemetry.ExportCsv"),
+	TEXT("Converts a helicopter telemetry recording to CSV.\n")
+	TEXT("Usage: heli.Telemetry.ExportCsv <InFilePath> [OutFilePath=<InFilePath>.csv]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogHelicopterMovement, Warning, TEXT("Usage: heli.Telemetry.ExportCsv <InFilePath> [OutFilePath]"));
+			return;
+		}
+		UHelicopterTelemetrySubsystem::ExportCsv(Args[0], Args.Num() > 1 ? Args[1] : FPaths::ChangeExtension(Args[0], TEXT("csv")));
+	}));
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Engine/NetSerialization.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "HelicopterAmbientTrafficReplicator.generated.h"
+
+/* Forward Declarations */
+class AHelicopterBasePawn;
+class AHelicopterAmbientTrafficReplicator;
+struct FHelicopterAmbientTrafficArray;
+
+/* * * Compact flight state of one ambient helicopter, clients simulate from it until the next resync * * */
+USTRUCT()
+struct FHelicopterAmbientTrafficItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/* Stable across promotions and swaps, the index in the array is not */
+	UPROPERTY()
+	int32 AmbientId = INDEX_NONE;
+
+	UPROPERTY()
+	FVector_NetQuantize Position;
+
+	UPROPERTY()
+	FVector_NetQuantize Velocity;
+
+	UPROPERTY()
+	FVector_NetQuantize Destination;
+
+	/* Compressed with FRotator::CompressAxisToShort */
+	UPROPERTY()
+	uint16 Yaw = 0;
+
+	void PostReplicatedAdd(const FHelicopterAmbientTrafficArray& InArraySerializer);
+	void PostReplicatedChange(const FHelicopterAmbientTrafficArray& InArraySerializer);
+	void PreReplicatedRemove(const FHelicopterAmbientTrafficArray& InArraySerializer);
+};
+
+/* * * Every ambient helicopter, only the items that changed since the last send are replicated * * */
+USTRUCT()
+struct FHelicopterAmbientTrafficArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FHelicopterAmbientTrafficItem> Items;
+
+	/* Actor the array lives on, set on every machine */
+	UPROPERTY(NotReplicated)
+	TObjectPtr<AHelicopterAmbientTrafficReplicator> Owner;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FHelicopterAmbientTrafficItem, FHelicopterAmbientTrafficArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FHelicopterAmbientTrafficArray> : public TStructOpsTypeTraitsBase2<FHelicopterAmbientTrafficArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/* * * Carries ambient traffic from the server to clients * * */
+// Spawned by UHelicopterAmbientTrafficSubsystem on servers. Clients get the helicopter class, the area and a fast array of
+// compact flight states, run the same Mass flight processor locally and draw the result with their own instanced mesh.
+// The server only resends a slice of the helicopters each frame to pull client simulations back in line.
+UCLASS(NotPlaceable, Transient)
+class HELICOPTERMOVEMENT_API AHelicopterAmbientTrafficReplicator : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AHelicopterAmbientTrafficReplicator();
+
+	virtual void PostInitializeComponents() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/* Server only, what the clients need to fly and draw the traffic */
+	void SetTrafficSetup(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, const FBox& InArea);
+
+	/* Server only, kept in the same order as the subsystem's entities */
+	void AddAmbient(int32 AmbientId, const FTransform& Transform, const FVector& Velocity, const FVector& Destination);
+	void UpdateAmbient(int32 Index, const FTransform& Transform, const FVector& Velocity, const FVector& Destination);
+	void RemoveAmbientAtSwap(int32 Index);
+
+	TSubclassOf<AHelicopterBasePawn> GetHelicopterClass() const { return HelicopterClass; }
+	const FBox& GetArea() const { return Area; }
+	const FHelicopterAmbientTrafficArray& GetTraffic() const { return Traffic; }
+
+protected:
+	UFUNCTION()
+	void OnRep_TrafficSetup();
+
+private:
+	static void WriteItem(FHelicopterAmbientTrafficItem& Item, const FTransform& Transform, const FVector& Velocity, const FVector& Destination);
+
+	UPROPERTY(ReplicatedUsing = OnRep_TrafficSetup)
+	TSubclassOf<AHelicopterBasePawn> HelicopterClass;
+
+	UPROPERTY(ReplicatedUsing = OnRep_TrafficSetup)
+	FBox Area;
+
+	UPROPERTY(Replicated)
+	FHelicopterAmbientTrafficArray Traffic;
+};
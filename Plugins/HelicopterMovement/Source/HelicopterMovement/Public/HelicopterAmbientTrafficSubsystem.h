@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MassEntityTypes.h"
+#include "MassArchetypeTypes.h"
+#include "HelicopterAmbientTrafficSubsystem.generated.h"
+
+/* Forward Declarations */
+class AHelicopterBasePawn;
+class AHelicopterAmbientTrafficReplicator;
+class UHelicopterAmbientFlightProcessor;
+struct FHelicopterAmbientTrafficItem;
+class UInstancedStaticMeshComponent;
+
+/* * * A helicopter that was promoted from ambient traffic to a full pawn * * */
+USTRUCT()
+struct FHelicopterPromotedAmbient
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<AHelicopterBasePawn> Helicopter;
+
+	/* Ambient destination the autopilot keeps flying to, handed back on demotion */
+	FVector Destination = FVector::ZeroVector;
+};
+
+/* * * Background helicopter traffic simulated as Mass entities and drawn with instanced meshes * * */
+// Ambient helicopters run the same flight model as UHelicopterMoverComponent without any actors. When a player gets
+// within PromoteDistance they are swapped for a full AHelicopterBasePawn flown by the autopilot, and swapped back once
+// every player is beyond DemoteDistance. The authority owns the traffic and sends it to clients through an
+// AHelicopterAmbientTrafficReplicator; clients fly the same entities locally and draw them with their own instanced mesh,
+// and each helicopter is resent every AmbientResyncInterval to pull the client simulation back in line. Fleets over
+// net.MaxNumberOfAllowedTArrayChangesPerUpdate helicopters need that limit raised for the first send to a client.
+UCLASS(Config = Game)
+class HELICOPTERMOVEMENT_API UHelicopterAmbientTrafficSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/* Adds Count ambient helicopters of the given class wandering inside Area */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Ambient Traffic")
+	void SpawnAmbientHelicopters(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, int32 Count, FBox InArea);
+
+	/* Promotes the closest ambient helicopter within MaxDistance, for interactions that happen before the LOD catches up */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Ambient Traffic")
+	AHelicopterBasePawn* PromoteClosestAmbientHelicopter(FVector Location, float MaxDistance);
+
+	UFUNCTION(BlueprintPure, Category = "Helicopter Ambient Traffic")
+	int32 GetNumAmbientHelicopters() const { return AmbientEntities.Num(); }
+
+	/* Distance to the closest player at which an ambient helicopter becomes a full pawn */
+	UPROPERTY(Config, EditAnywhere, Category = "Helicopter Ambient Traffic")
+	float PromoteDistance = 8000.0f;
+
+	/* Distance every player has to be beyond before a promoted pawn goes back to ambient traffic */
+	UPROPERTY(Config, EditAnywhere, Category = "Helicopter Ambient Traffic")
+	float DemoteDistance = 12000.0f;
+
+	/* Seconds between promotion/demotion checks */
+	UPROPERTY(Config, EditAnywhere, Category = "Helicopter Ambient Traffic")
+	float LODUpdateInterval = 0.25f;
+
+	/* Most ambient helicopters turned into pawns per LOD update, closest first, so a player arriving in dense traffic does not spawn them all in one frame */
+	UPROPERTY(Config, EditAnywhere, Category = "Helicopter Ambient Traffic")
+	int32 MaxPromotionsPerUpdate = 4;
+
+	/* Seconds over which every ambient helicopter is resent to clients once, spread evenly over the frames */
+	UPROPERTY(Config, EditAnywhere, Category = "Helicopter Ambient Traffic")
+	float AmbientResyncInterval = 2.0f;
+
+	/* Client side, called by the replicator as the traffic arrives */
+	void SetupReplicatedTraffic(const AHelicopterAmbientTrafficReplicator* InReplicator);
+	void AddReplicatedAmbient(const FHelicopterAmbientTrafficItem& Item);
+	void UpdateReplicatedAmbient(const FHelicopterAmbientTrafficItem& Item);
+	void RemoveReplicatedAmbient(int32 AmbientId);
+
+private:
+	/* Flight tuning and instanced mesh for a helicopter class, on the server and on clients */
+	void SetupAmbientClass(TSubclassOf<AHelicopterBasePawn> InHelicopterClass, const FBox& InArea);
+
+	void CreateAmbientEntity(int32 AmbientId, const FTransform& Transform, const FVector& Velocity, float YawSpeed, const FVector& Destination);
+	void RemoveAmbientAt(int32 AmbientIndex);
+	AHelicopterBasePawn* Promote(int32 AmbientIndex);
+	void Demote(int32 PromotedIndex);
+
+	void UpdateLOD();
+	void UpdateInstances();
+	void ResyncAmbient(float DeltaTime);
+	void GatherViewLocations(TArray<FVector>& OutViewLocations) const;
+
+	UPROPERTY()
+	TSubclassOf<AHelicopterBasePawn> HelicopterClass;
+
+	UPROPERTY()
+	TObjectPtr<UHelicopterAmbientFlightProcessor> FlightProcessor;
+
+	/* Instanced mesh used to draw ambient traffic, not created on dedicated servers */
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	UPROPERTY()
+	TArray<FHelicopterPromotedAmbient> Promoted;
+
+	/* Server only, replicates the traffic to clients */
+	UPROPERTY()
+	TObjectPtr<AHelicopterAmbientTrafficReplicator> Replicator;
+
+	/* Ambient entities, kept in the same order as the instances, the ids and the replicated items so removal can swap all of them */
+	TArray<FMassEntityHandle> AmbientEntities;
+	TArray<int32> AmbientIds;
+	TMap<int32, int32> AmbientIndexById;
+	int32 NextAmbientId = 0;
+
+	/* Scratch list of ambient helicopters in promotion range, squared distance to the closest player and index */
+	TArray<TPair<float, int32>> PromotionCandidates;
+
+	/* Next helicopter to resend, and the fraction of one left over from the last frame */
+	int32 ResyncCursor = 0;
+	float ResyncBudget = 0.0f;
+
+	FMassArchetypeHandle AmbientArchetype;
+	FMassArchetypeSharedFragmentValues AmbientSharedValues;
+	FBox Area = FBox(ForceInit);
+	float TimeSinceLODUpdate = 0.0f;
+};
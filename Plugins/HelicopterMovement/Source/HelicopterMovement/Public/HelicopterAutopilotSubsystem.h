@@ -0,0 +1,121 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HelicopterAutopilotSubsystem.generated.h"
+
+/* Forward Declarations */
+class UHelicopterMoverComponent;
+class USplineComponent;
+
+UENUM(BlueprintType)
+enum class EAutopilot_Mode : uint8
+{
+	EAM_HoverHold UMETA(DisplayName = "Hover Hold"),
+	EAM_AltitudeHold UMETA(DisplayName = "Altitude Hold"),
+	EAM_Waypoints UMETA(DisplayName = "Waypoints"),
+	EAM_Spline UMETA(DisplayName = "Spline"),
+	EAM_Orbit UMETA(DisplayName = "Orbit"),
+
+	EAM_Max UMETA(DisplayName = "Default Max")
+};
+
+/* * * What an AI helicopter should be doing, handed to the autopilot by gameplay code * * */
+USTRUCT(BlueprintType)
+struct FHelicopterAutopilotOrder
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot")
+	EAutopilot_Mode Mode = EAutopilot_Mode::EAM_HoverHold;
+
+	/* Location to hover at, or the altitude to keep for altitude hold */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Hold")
+	FVector HoldLocation = FVector::ZeroVector;
+
+	/* Forward/lateral input flown while holding altitude */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Hold")
+	FVector2D CruiseInput = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Path")
+	TArray<FVector> Waypoints;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Path")
+	bool bLoopPath = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Path")
+	TObjectPtr<USplineComponent> Spline;
+
+	/* How far along the path the helicopter aims, keeps it at cruise speed instead of slowing at every point */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Path")
+	float LookAheadDistance = 1500.0f;
+
+	/* Distance at which a waypoint counts as reached */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Path")
+	float AcceptanceRadius = 300.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Orbit")
+	FVector OrbitCenter = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Orbit")
+	float OrbitRadius = 3000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot | Orbit")
+	bool bOrbitClockwise = true;
+
+	/* Speed limit for the order, zero uses the helicopter's MaxForwardSpeed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Autopilot")
+	float CruiseSpeed = 0.0f;
+};
+
+/* * * Runtime state for a single AI helicopter * * */
+USTRUCT()
+struct FHelicopterAutopilot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<UHelicopterMoverComponent> Mover;
+
+	UPROPERTY()
+	FHelicopterAutopilotOrder Order;
+
+	int32 WaypointIndex = 0;
+	FVector PositionErrorIntegral = FVector::ZeroVector;
+	float HoldYaw = 0.0f;
+};
+
+/* * * Server-side autopilot that computes the inputs of every AI helicopter in one batched pass * * */
+// AI helicopters do not go through the client prediction and input RPC path, the autopilot writes
+// DesiredInput/DesiredYawInput directly on the server the same way the pawn's input handlers do locally.
+UCLASS()
+class HELICOPTERMOVEMENT_API UHelicopterAutopilotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/* Hands the helicopter to the autopilot, or updates its order if it is already engaged */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Autopilot")
+	void EngageAutopilot(UHelicopterMoverComponent* Mover, const FHelicopterAutopilotOrder& Order);
+
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Autopilot")
+	void DisengageAutopilot(UHelicopterMoverComponent* Mover);
+
+	UFUNCTION(BlueprintPure, Category = "Helicopter Autopilot")
+	bool IsAutopilotEngaged(const UHelicopterMoverComponent* Mover) const;
+
+private:
+	/* Picks the point the helicopter should currently fly toward, advancing waypoints as they are reached */
+	static FVector ComputeTargetLocation(FHelicopterAutopilot& Pilot, const FVector& Location);
+
+	/* Turns the target into inputs using PID gains derived from the mover's speed and damping */
+	static void ComputeInputs(FHelicopterAutopilot& Pilot, UHelicopterMoverComponent& Mover, float DeltaTime);
+
+	UPROPERTY()
+	TArray<FHelicopterAutopilot> Pilots;
+};
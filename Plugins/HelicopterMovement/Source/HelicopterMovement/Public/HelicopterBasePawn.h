@@ -4,10 +4,13 @@
 #include "GameFramework/Pawn.h"
 #include "InputMappingContext.h"
 #include "InputAction.h"
+#include "Engine/NetSerialization.h"
 #include "HelicopterBasePawn.generated.h"
 
 /* Forward Declarations */
 class UHelicopterMoverComponent;
+class UHelicopterClockSyncComponent;
+class USphereComponent;
 
 UENUM(BlueprintType)
 enum class EEngine_State : uint8
@@ -20,6 +23,57 @@ enum class EEngine_State : uint8
 	EES_Max UMETA(DisplayName = "Default Max")
 };
 
+/* * * Last engine transition, clients derive the rotor speed from it instead of replicating it every frame * * */
+USTRUCT()
+struct FHelicopterEngineTransition
+{
+	GENERATED_BODY()
+
+	/* Either EES_EngineOn for a spin up or EES_EngineOff for a spin down */
+	UPROPERTY()
+	EEngine_State TargetState = EEngine_State::EES_EngineOff;
+
+	/* Server world time the transition started at */
+	UPROPERTY()
+	double StartServerTime = 0.0;
+
+	/* Rotor speed when the transition started, a spin down can interrupt a spin up part way */
+	UPROPERTY()
+	float StartRotorSpeed = 0.0f;
+};
+
+/* * * Who sits in a seat, only the seat and the offset from it are replicated for the occupant * * */
+USTRUCT(BlueprintType)
+struct FHelicopterSeatAssignment
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Helicopter Seating")
+	TObjectPtr<AActor> Occupant = nullptr;
+
+	/* 0 is the pilot's seat, 1 the left passenger and 2 the right passenger */
+	UPROPERTY(BlueprintReadOnly, Category = "Helicopter Seating")
+	uint8 SeatIndex = 0;
+
+	/* Occupant location relative to the seat */
+	UPROPERTY(BlueprintReadOnly, Category = "Helicopter Seating")
+	FVector_NetQuantize10 RelativeOffset = FVector::ZeroVector;
+
+	/* Collision is turned back on everywhere the occupant leaves, so this one bit travels with the seat */
+	UPROPERTY()
+	bool bWasCollisionEnabled = true;
+
+	/* Server only, restored when the occupant leaves the seat */
+	UPROPERTY(NotReplicated)
+	float PreviousNetUpdateFrequency = 0.0f;
+
+	UPROPERTY(NotReplicated)
+	bool bWasReplicatingMovement = false;
+
+	UPROPERTY(NotReplicated)
+	bool bWasSimulatingPhysics = false;
+};
+
 UCLASS()
 class HELICOPTERMOVEMENT_API AHelicopterBasePawn : public APawn
 {
@@ -28,11 +82,18 @@ class HELICOPTERMOVEMENT_API AHelicopterBasePawn : public APawn
 public:
 	AHelicopterBasePawn();
 
+	virtual void OnConstruction(const FTransform& Transform) override;
 	virtual void Tick(float DeltaSeconds) override;
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void NotifyControllerChanged() override;
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 
 	/* * * Helicopter Components * * */
 	
+	/* Sized to match the mover's collision sphere */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Core Components")
+	TObjectPtr<USphereComponent> CollisionRoot;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Core Components")
 	TObjectPtr<UStaticMeshComponent> HelicopterBody;
 
@@ -45,6 +106,9 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Core Components")
 	TObjectPtr<UHelicopterMoverComponent> HelicopterMover;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Core Components")
+	TObjectPtr<UHelicopterClockSyncComponent> ClockSync;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Helicopter Properties | Seating")
 	TObjectPtr<USceneComponent> PilotsSeat;
 
@@ -54,6 +118,30 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Helicopter Properties | Seating")
 	TObjectPtr<USceneComponent> RightPassenger;
 
+	/* Net update frequency given to occupants while seated, they only replicate gameplay state while riding along */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Helicopter Properties | Seating")
+	float SeatedOccupantNetUpdateFrequency;
+
+	/* * * Seating * * */
+
+	/* Server only, attaches the occupant to a free seat and suspends its own movement */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Seating")
+	bool SeatOccupant(AActor* Occupant, int32 SeatIndex, FVector RelativeOffset);
+
+	/* Server only, detaches the occupant and gives it back its own movement */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Helicopter Seating")
+	void UnseatOccupant(AActor* Occupant);
+
+	UFUNCTION(BlueprintPure, Category = "Helicopter Seating")
+	AActor* GetSeatOccupant(int32 SeatIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = "Helicopter Seating")
+	USceneComponent* GetSeatComponent(int32 SeatIndex) const;
+
+	const TArray<FHelicopterSeatAssignment>& GetSeatAssignments() const { return SeatAssignments; }
+
+	static constexpr int32 NumSeats = 3;
+
 	/* Input Mapping Context */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Input Actions")
 	TObjectPtr<UInputMappingContext> HelicopterInputMapping;
@@ -76,16 +164,26 @@ public:
 	UPROPERTY(ReplicatedUsing=OnRep_EngineState, VisibleAnywhere, BlueprintReadOnly, Category="Helicopter Properties | Engines")
 	EEngine_State EngineState;
 
-	// Replication handler for RotorSpeed
+	/* Server only, puts the engine straight into a state without going through spin up or spin down */
+	void RestoreEngineState(EEngine_State NewState, float NewRotorSpeed);
+
+	/* Rotor speed from 0 to 1, derived from the last engine transition and the server time */
+	float GetRotorSpeed() const;
+
+	// Replication handler for EngineTransition
 	UFUNCTION()
-	void OnRep_RotorSpeed();
+	void OnRep_EngineTransition();
 
 	// Replication handler for EngineState
 	UFUNCTION()
 	void OnRep_EngineState();
 
+	UFUNCTION()
+	void OnRep_SeatAssignments(const TArray<FHelicopterSeatAssignment>& PreviousAssignments);
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
 
@@ -102,9 +200,22 @@ private:
 	UFUNCTION(Server, Reliable)
 	void Server_ToggleEngines();
 	void ToggleEngines();
-	void UpdateRotorSpeed(float DeltaTime);
 	void SpinRotors(float DeltaTime);
 
+	/* Starts a spin up or spin down from the current rotor speed and schedules its completion */
+	void BeginEngineTransition(EEngine_State TargetState, float StartRotorSpeed);
+	void FinishEngineTransition();
+
+	/* Puts an occupant into or out of its seat locally, run on the server and on clients when the assignments replicate */
+	void AttachSeatOccupant(const FHelicopterSeatAssignment& Assignment);
+	void DetachSeatOccupant(const FHelicopterSeatAssignment& Assignment);
+	void SetOccupantMovementSuspended(AActor* Occupant, bool bSuspended);
+	void NotifyReplicationGraphOfOccupant(AActor* Occupant, bool bSeated);
+
+	/* The pawn only ticks to spin the rotors, so it sleeps while the engine is off and on dedicated servers */
+	void UpdateTickEnabled();
+	double GetServerTime() const;
+
 	// Input handlers
 	void HandleMovementInput(const FInputActionValue& Value);
 	void HandleMovementInputReleased(const FInputActionValue& Value);
@@ -117,6 +228,11 @@ private:
 
 	// Rotor-related state
 	bool bIsStartingUp;
-	UPROPERTY(ReplicatedUsing=OnRep_RotorSpeed)
-	float RotorSpeed;
+	UPROPERTY(ReplicatedUsing=OnRep_EngineTransition)
+	FHelicopterEngineTransition EngineTransition;
+
+	FTimerHandle EngineTransitionTimer;
+
+	UPROPERTY(ReplicatedUsing=OnRep_SeatAssignments)
+	TArray<FHelicopterSeatAssignment> SeatAssignments;
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "HelicopterClockSyncComponent.generated.h"
+
+/* * * One ping round trip used to estimate the server clock * * */
+struct FHelicopterClockSample
+{
+	double RoundTripTime = 0.0;
+	double Offset = 0.0;
+};
+
+/* * * Estimates the server clock on the owning client so inputs and states share one timebase * * */
+// The owning client pings the server over unreliable RPCs. Each reply gives an offset estimate of
+// ServerTime + RTT / 2 - ClientTime, and only the lowest RTT samples in the window are trusted, since
+// queueing delay only ever makes a sample worse. The server and simulated proxies just use the server clock and
+// do not tick. Both ends use world time, differences in dilation, pauses or hitch clamping are picked up by the
+// next ping.
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class HELICOPTERMOVEMENT_API UHelicopterClockSyncComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHelicopterClockSyncComponent();
+
+	/* Current time on the server's clock, estimated on clients */
+	UFUNCTION(BlueprintPure, Category = "Helicopter Clock Sync")
+	double GetServerTime() const;
+
+	/* True once the owning client has enough samples to trust the offset */
+	UFUNCTION(BlueprintPure, Category = "Helicopter Clock Sync")
+	bool IsSynchronized() const { return bHasOffset; }
+
+	/* Lowest round trip time in the current sample window */
+	UFUNCTION(BlueprintPure, Category = "Helicopter Clock Sync")
+	double GetRoundTripTime() const { return BestRoundTripTime; }
+
+	/* Ticks only while the owner is controlled by this client, called when the owner's controller changes */
+	void UpdateTickEnabled();
+
+	/* Seconds between pings once synchronized */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Clock Sync")
+	float PingInterval;
+
+	/* Seconds between pings while still gathering the first samples */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Clock Sync")
+	float InitialPingInterval;
+
+	/* Number of recent samples the offset is chosen from */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Clock Sync")
+	int32 SampleWindowSize;
+
+	/* Offset changes bigger than this snap instead of slewing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Clock Sync")
+	float SnapThreshold;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UFUNCTION(Server, Unreliable)
+	void Server_Ping(double ClientSendTime);
+
+	UFUNCTION(Client, Unreliable)
+	void Client_Pong(double ClientSendTime, double ServerTime);
+
+private:
+	bool IsOwningClient() const;
+	double GetLocalTime() const;
+	void AddSample(const FHelicopterClockSample& Sample);
+
+	/* Ring of the most recent samples */
+	TArray<FHelicopterClockSample> Samples;
+	int32 NextSampleIndex;
+
+	double Offset;
+	double BestRoundTripTime;
+	bool bHasOffset;
+};
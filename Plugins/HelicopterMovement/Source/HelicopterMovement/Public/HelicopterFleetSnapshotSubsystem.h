@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HelicopterBasePawn.h"
+#include "HelicopterFleetSnapshotSubsystem.generated.h"
+
+/* * * Saved occupant of one seat, player controlled occupants are not saved * * */
+struct FHelicopterSnapshotSeat
+{
+	/* Index into the snapshot's class table */
+	uint16 OccupantClassIndex = 0;
+
+	uint8 SeatIndex = 0;
+	FVector RelativeOffset = FVector::ZeroVector;
+
+	friend FArchive& operator<<(FArchive& Ar, FHelicopterSnapshotSeat& Seat)
+	{
+		return Ar << Seat.OccupantClassIndex << Seat.SeatIndex << Seat.RelativeOffset;
+	}
+};
+
+/* * * Saved state of one helicopter * * */
+struct FHelicopterSnapshotEntry
+{
+	/* Index into the snapshot's class table */
+	uint16 ClassIndex = 0;
+
+	FVector Position = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FVector Velocity = FVector::ZeroVector;
+	float YawSpeed = 0.0f;
+
+	EEngine_State EngineState = EEngine_State::EES_EngineOff;
+	float RotorSpeed = 0.0f;
+
+	/* Added in version 2 */
+	TArray<FHelicopterSnapshotSeat> Seats;
+
+	void Serialize(FArchive& Ar, int32 Version);
+
+	/* Bytes an entry takes in the oldest version, bounds the entry count read from a snapshot */
+	static constexpr int64 MinSerializedSize = sizeof(uint16) + sizeof(FVector) * 2 + sizeof(FRotator) + sizeof(float) * 2 + sizeof(uint8);
+};
+
+/* * * Saves every helicopter in the world to a compact binary snapshot and spawns them back from it * * */
+// Used to bring a fleet back in flight after a server restart or to move it to another server. The snapshot is
+// versioned, older snapshots stay loadable when fields are added. Restores spawn every helicopter deferred before
+// finishing any of them, so each helicopter's construction script and BeginPlay already see the whole fleet.
+// AI and other non player occupants are saved with their seat and spawned back into it, players are left out.
+UCLASS()
+class HELICOPTERMOVEMENT_API UHelicopterFleetSnapshotSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/* Serializes every helicopter in the world, server only */
+	bool SaveSnapshot(TArray<uint8>& OutData) const;
+
+	/* Spawns the helicopters in a snapshot, optionally destroying the ones already in the world, returns how many were restored */
+	int32 RestoreSnapshot(const TArray<uint8>& Data, bool bDestroyExisting);
+
+	UFUNCTION(BlueprintCallable, Category = "Helicopter Fleet Snapshot")
+	bool SaveSnapshotToFile(const FString& FilePath) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Helicopter Fleet Snapshot")
+	int32 RestoreSnapshotFromFile(const FString& FilePath, bool bDestroyExisting = true);
+
+	static FString GetDefaultSnapshotPath();
+
+	static constexpr uint32 SnapshotMagic = 0x53464648; // "HFFS"
+	static constexpr int32 SnapshotVersion = 2;
+};
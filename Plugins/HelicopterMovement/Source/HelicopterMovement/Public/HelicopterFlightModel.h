@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* * * Tuning values the flight model needs to integrate a single step * * */
+struct FHelicopterFlightParams
+{
+	float MaxForwardSpeed = 1500.0f;
+	float MaxLateralSpeed = 1000.0f;
+	float MaxVerticalSpeed = 500.0f;
+	float YawSpeed = 90.0f;
+	float VelocityDamping = 0.95f;
+};
+
+/* * * Stateless helicopter flight model shared by every movement path * * */
+// Only touches the values passed in so it is safe to run for many helicopters at once on any thread.
+struct FHelicopterFlightModel
+{
+	/* Velocity the helicopter is trying to reach for the given input, relative to its current facing */
+	static FVector ComputeTargetVelocity(const FRotator& Rotation, const FVector& DesiredInput, const FHelicopterFlightParams& Params)
+	{
+		const FRotationMatrix RotationMatrix(Rotation);
+		const FVector Forward = RotationMatrix.GetScaledAxis(EAxis::X);
+		const FVector Right = RotationMatrix.GetScaledAxis(EAxis::Y);
+
+		return Forward * DesiredInput.X * Params.MaxForwardSpeed +
+			Right * DesiredInput.Y * Params.MaxLateralSpeed +
+			FVector::UpVector * DesiredInput.Z * Params.MaxVerticalSpeed;
+	}
+
+	/* Stick input that makes the helicopter chase a world space velocity, the inverse of ComputeTargetVelocity */
+	static FVector ComputeInputForVelocity(const FRotator& Rotation, const FVector& DesiredVelocity, const FHelicopterFlightParams& Params)
+	{
+		const FVector LocalVelocity = FRotator(0.0f, Rotation.Yaw, 0.0f).UnrotateVector(DesiredVelocity);
+		const FVector Input(
+			LocalVelocity.X / FMath::Max(Params.MaxForwardSpeed, 1.0f),
+			LocalVelocity.Y / FMath::Max(Params.MaxLateralSpeed, 1.0f),
+			DesiredVelocity.Z / FMath::Max(Params.MaxVerticalSpeed, 1.0f));
+
+		return Input.BoundToBox(FVector(-1.0f), FVector(1.0f));
+	}
+
+	/* Smooths the velocity and yaw speed toward the input targets and returns the new rotation */
+	static FRotator Integrate(const FRotator& Rotation, const FVector& DesiredInput, float DesiredYawInput,
+		const FHelicopterFlightParams& Params, float DeltaTime, FVector& InOutVelocity, float& InOutYawSpeed)
+	{
+		const FVector TargetVelocity = ComputeTargetVelocity(Rotation, DesiredInput, Params);
+		InOutVelocity = FMath::VInterpTo(InOutVelocity, TargetVelocity, DeltaTime, Params.VelocityDamping);
+
+		const float TargetYawSpeed = DesiredYawInput * Params.YawSpeed;
+		InOutYawSpeed = FMath::FInterpTo(InOutYawSpeed, TargetYawSpeed, DeltaTime, Params.VelocityDamping);
+
+		// Preserve the pitch and roll while updating yaw
+		return FRotator(Rotation.Pitch, Rotation.Yaw + InOutYawSpeed * DeltaTime, Rotation.Roll);
+	}
+};
@@ -4,6 +4,91 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
+#include <atomic>
+
+HELICOPTERMOVEMENT_API DECLARE_LOG_CATEGORY_EXTERN(LogHelicopterMovement, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("HelicopterMovement"), STATGROUP_HelicopterMovement, STATCAT_Advanced);
+
+/* Movement counters for the benchmark commandlet, compiled out of shipping builds */
+#ifndef HELICOPTER_MOVEMENT_COUNTERS
+#define HELICOPTER_MOVEMENT_COUNTERS !UE_BUILD_SHIPPING
+#endif
+
+/* * * Movement counters, read by the benchmark commandlet where stats are not available * * */
+// Nothing is counted until the commandlet enables them, so the only cost elsewhere is a relaxed load of the flag.
+struct HELICOPTERMOVEMENT_API FHelicopterMovementCounters
+{
+#if HELICOPTER_MOVEMENT_COUNTERS
+	static void SetEnabled(bool bInEnabled)
+	{
+		bEnabled.store(bInEnabled, std::memory_order_relaxed);
+	}
+
+	static bool IsEnabled()
+	{
+		return bEnabled.load(std::memory_order_relaxed);
+	}
+
+	static void Reset()
+	{
+		NumSweeps.store(0, std::memory_order_relaxed);
+		MoverCycles.store(0, std::memory_order_relaxed);
+	}
+
+	/* Callers on worker threads add once per batch, not once per sweep */
+	static void CountSweeps(uint64 Num)
+	{
+		if (IsEnabled())
+		{
+			NumSweeps.fetch_add(Num, std::memory_order_relaxed);
+		}
+	}
+
+	static void AddMoverCycles(uint64 Cycles)
+	{
+		MoverCycles.fetch_add(Cycles, std::memory_order_relaxed);
+	}
+
+	static uint64 GetNumSweeps() { return NumSweeps.load(std::memory_order_relaxed); }
+	static uint64 GetMoverCycles() { return MoverCycles.load(std::memory_order_relaxed); }
+
+private:
+	static std::atomic<bool> bEnabled;
+
+	/* Scene query sweeps issued by movers, from any thread */
+	static std::atomic<uint64> NumSweeps;
+
+	/* Game thread cycles spent in mover ticks and the mover subsystem */
+	static std::atomic<uint64> MoverCycles;
+#else
+	static void SetEnabled(bool bInEnabled) { }
+	static bool IsEnabled() { return false; }
+	static void Reset() { }
+	static void CountSweeps(uint64 Num) { }
+	static uint64 GetNumSweeps() { return 0; }
+	static uint64 GetMoverCycles() { return 0; }
+#endif
+};
+
+/* Adds the cycles spent in its scope to the mover cycle counter while the counters are enabled */
+struct FHelicopterMoverCycleScope
+{
+#if HELICOPTER_MOVEMENT_COUNTERS
+	FHelicopterMoverCycleScope() : StartCycles(FHelicopterMovementCounters::IsEnabled() ? FPlatformTime::Cycles64() : 0) { }
+	~FHelicopterMoverCycleScope()
+	{
+		if (StartCycles != 0)
+		{
+			FHelicopterMovementCounters::AddMoverCycles(FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	uint64 StartCycles;
+#endif
+};
 
 class FHelicopterMovementModule : public IModuleInterface
 {
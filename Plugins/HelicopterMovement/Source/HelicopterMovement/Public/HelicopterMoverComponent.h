@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "HelicopterFlightModel.h"
 #include "HelicopterMoverComponent.generated.h"
 
 /* * * Struct to hold state data for prediction and reconciliation * * */
@@ -19,8 +20,9 @@ struct FHelicopterState
 	UPROPERTY()
 	FVector Velocity;
 
+	/* Server clock time, see UHelicopterClockSyncComponent */
 	UPROPERTY()
-	float Timestamp;
+	double Timestamp;
 };
 
 /* * * Struct for inputs used in movement prediction * * */
@@ -35,8 +37,22 @@ struct FHelicopterInput
 	UPROPERTY()
 	float DesiredYawInput;
 
+	/* Client's estimate of the server clock when the input was applied */
 	UPROPERTY()
-	float Timestamp;
+	double Timestamp;
+};
+
+/* Forward Declarations */
+class UHelicopterClockSyncComponent;
+
+/* * * A single movement step split into its integration, query and commit phases * * */
+struct FHelicopterMove
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	FHitResult HitResult;
+	bool bHit = false;
 };
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
@@ -96,9 +112,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Colliding")
 	float CollisionSphere;
 
-	/* The interpolation speed for position error correction */
+	/* Seconds for half of a correction's visual offset to fade out, the simulation itself snaps straight away */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Server Corrections")
+	float VisualCorrectionHalfLife;
+
+	/* Corrections bigger than this are treated as teleports and snap the visuals as well */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Server Corrections")
-	float CorrectionInterpolation;
+	float MaxVisualCorrectionDistance;
 
 	/* How many units the client can be off before being corrected by the server */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Server Corrections")
@@ -107,6 +127,30 @@ public:
 	/* How many degrees the client can be off before being corrected by the server */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Server Corrections")
 	float RotationErrorThreshold;
+
+	/* Lets a resting helicopter stop ticking, sweeping and replicating until something wakes it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Sleeping")
+	bool bAllowSleep;
+
+	/* Speed below which the helicopter counts as resting */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Sleeping")
+	float SleepVelocityThreshold;
+
+	/* How long the helicopter has to rest before it goes to sleep */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Sleeping")
+	float SleepDelay;
+
+	/* How far below the helicopter a surface has to be for it to count as grounded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Sleeping")
+	float GroundProbeDistance;
+
+	/* How often a sleeping helicopter re-checks the ground under it, and a hovering one probes for ground to land on */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Sleeping")
+	float SleepCheckInterval;
+	
+	/* Integrates this helicopter on the physics thread at the fixed physics rate, authority only. Needs Tick Physics Async in the project settings */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Helicopter Properties | Async Physics")
+	bool bUseAsyncPhysics;
 	
 	/* Input variables */
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Input")
@@ -114,8 +158,37 @@ public:
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category = "Helicopter Properties | Input")
 	float DesiredYawInput;
 
+	/* Set by the autopilot subsystem, AI helicopters skip the client prediction and input RPC path */
+	void SetAutopilotEngaged(bool bEngaged);
+	bool IsAutopilotEngaged() const { return bAutopilotEngaged; }
+
+	FVector GetCurrentVelocity() const { return CurrentVelocity; }
+	FHelicopterFlightParams GetFlightParams() const;
+	float GetCurrentYawSpeed() const { return CurrentYawSpeed; }
+	uint32 GetTelemetryId() const { return TelemetryId; }
+
+	/* Captures and restores the simulated state, used when handing a helicopter between representations */
+	FHelicopterState GetMoverState() const;
+	void SetMoverState(const FHelicopterState& State, float InYawSpeed);
+
+	/* Pushes the helicopter and wakes it up if it is sleeping */
+	UFUNCTION(BlueprintCallable, Category = "Helicopter Movement")
+	void AddImpulse(FVector VelocityChange);
+
+	/* Resumes ticking and replication, called whenever input arrives */
+	UFUNCTION(BlueprintCallable, Category = "Helicopter Movement")
+	void WakeUp();
+
+	UFUNCTION(BlueprintPure, Category = "Helicopter Movement")
+	bool IsSleeping() const { return bIsSleeping; }
+
+	/* Child component that is tilted and carries the correction offsets, without one the root is tilted and corrections snap */
+	UFUNCTION(BlueprintCallable, Category = "Helicopter Movement")
+	void SetVisualComponent(USceneComponent* InVisualComponent);
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	/* Networking */
@@ -128,16 +201,29 @@ protected:
 	UFUNCTION()
 	void OnRep_ServerState();
 
+	UFUNCTION()
+	void OnRep_IsSleeping();
+
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 	/* Helper function to check for the controlling actor */
 	bool IsOwnerLocallyControlled() const;
 
 private:
+	friend class UHelicopterMoverSubsystem;
+
 	/* Movement functions */
 	void ApplyInput(float DeltaTime);
+
+	/* Integration phase, only reads and writes this helicopter so it can run on any thread */
+	void PrepareMove(float DeltaTime, FHelicopterMove& OutMove);
+	/* Scene query phase, safe on worker threads while the game thread is not moving actors */
+	void SweepMove(FHelicopterMove& Move) const;
+	/* Writes the result back to the owner, game thread only */
+	void CommitMove(const FHelicopterMove& Move, float DeltaTime);
+
 	void CorrectClientState();
-	void SavePredictedState(float Timestamp);
+	void SavePredictedState(double Timestamp);
 	void ReconcileState();
 	void UpdateServerState();
 
@@ -146,15 +232,70 @@ private:
 	/* Used to handle applying tilt to the helicopter body based on current velocity */
 	void ApplyBodyTilt(float DeltaTime);
 
+	/* Visual correction smoothing */
+	bool HasVisualOffsetComponent() const;
+	void AddVisualCorrection(const FTransform& PreviousTransform);
+	void DecayVisualCorrection(float DeltaTime);
+	void ResetVisualCorrection();
+
+	/* Sleep handling */
+	void UpdateSleep(float DeltaTime);
+	bool HasNoInput() const;
+	bool IsGrounded() const;
+	void GoToSleep();
+	void CheckSleepingSupport();
+
 	/* Current velocity and yaw speed */
 	UPROPERTY(Replicated, VisibleAnywhere, BlueprintReadOnly, Category="Helicopter Properties | Speed", meta=(AllowPrivateAccess = "true"))
 	FVector CurrentVelocity;
 	float CurrentYawSpeed;
 
+	/* True while the server autopilot is producing this helicopter's inputs */
+	UPROPERTY(Replicated)
+	bool bAutopilotEngaged;
+
+	/* Mesh the tilt and correction offsets are applied to, and its relative transform as authored */
+	UPROPERTY()
+	TObjectPtr<USceneComponent> VisualComponent;
+	FTransform VisualBaseTransform;
+
+	/* World space error left over from corrections, faded out on the visual component only */
+	FVector VisualLocationOffset;
+	FQuat VisualRotationOffset;
+	FRotator CurrentTilt;
+
+	/* Identifies the helicopter to the async physics callback, and the version of the state it should simulate from */
+	int32 AsyncPhysicsId;
+	uint32 AsyncStateVersion;
+
+	/* Names this helicopter in telemetry, unlike the object's unique id it is not reused after garbage collection */
+	uint32 TelemetryId;
+
+	/* True while the helicopter is resting and not ticking */
+	UPROPERTY(ReplicatedUsing = OnRep_IsSleeping)
+	bool bIsSleeping;
+
+	/* How long the helicopter has been resting without input */
+	float RestingTime;
+
+	FTimerHandle SleepCheckTimer;
+
 	/* State management */
 	UPROPERTY(Replicated, ReplicatedUsing = OnRep_ServerState)
 	FHelicopterState ServerState;
 
 	/* Predicted states for reconciliation */
 	TArray<FHelicopterState> PredictedStates;
+
+	/* Shared client/server timebase for input and state timestamps */
+	UPROPERTY()
+	TObjectPtr<UHelicopterClockSyncComponent> ClockSync;
+
+	/* Timestamp of the newest client input the server has applied, labels ServerState for reconciliation */
+	double LastProcessedInputTimestamp;
+
+	/* Timestamp of the newest input this client sent, each new one is clamped above it */
+	double LastSentInputTimestamp;
+
+	double GetSyncedTime() const;
 };
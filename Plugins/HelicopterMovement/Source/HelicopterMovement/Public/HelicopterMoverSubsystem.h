@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HelicopterMoverSubsystem.generated.h"
+
+/* Forward Declarations */
+class UHelicopterMoverComponent;
+class FHelicopterAsyncPhysicsCallback;
+
+/* * * Batches the authoritative movement of every helicopter in the world * * */
+// When heli.ParallelMovement is enabled the integration and sweep of each helicopter runs on task graph
+// workers with ParallelFor, and only the final transform commit happens on the game thread.
+// Movers with bUseAsyncPhysics are integrated on the physics thread instead, see FHelicopterAsyncPhysicsCallback.
+UCLASS()
+class HELICOPTERMOVEMENT_API UHelicopterMoverSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterMover(UHelicopterMoverComponent* Mover);
+	void UnregisterMover(UHelicopterMoverComponent* Mover);
+
+	/* True when this subsystem, not the component tick, is responsible for integrating the mover */
+	bool IsDrivingMover(const UHelicopterMoverComponent* Mover) const;
+
+	/* Steps the given movers, splitting the integration and sweeps into NumTasks parallel chunks */
+	static void StepMovers(TArrayView<UHelicopterMoverComponent* const> Movers, float DeltaTime, int32 NumTasks);
+
+	/* Returns true if the parallel movement path is enabled */
+	static bool IsParallelMovementEnabled();
+
+	/* Commits the latest physics thread results of the given movers and queues their inputs for the next physics step */
+	void StepAsyncMovers(TArrayView<UHelicopterMoverComponent* const> InMovers, float DeltaTime);
+
+	const TArray<TObjectPtr<UHelicopterMoverComponent>>& GetMovers() const { return Movers; }
+
+private:
+	/* Every mover that has begun play in this world */
+	UPROPERTY()
+	TArray<TObjectPtr<UHelicopterMoverComponent>> Movers;
+
+	/* Scratch lists of authoritative movers gathered each tick */
+	TArray<UHelicopterMoverComponent*> AuthorityMovers;
+	TArray<UHelicopterMoverComponent*> AsyncMovers;
+
+	/* Registered with this world's Chaos solver the first time an async mover begins play */
+	bool EnsureAsyncCallback();
+	bool UsesAsyncPhysics(const UHelicopterMoverComponent* Mover) const;
+
+	FHelicopterAsyncPhysicsCallback* AsyncCallback = nullptr;
+	int32 NextAsyncPhysicsId = 0;
+};
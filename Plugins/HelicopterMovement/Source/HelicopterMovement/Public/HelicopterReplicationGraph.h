@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "HelicopterReplicationGraph.generated.h"
+
+/* Forward Declarations */
+class AHelicopterBasePawn;
+class UHelicopterReplicationGraph;
+
+/* * * Distance band a helicopter is replicated in, further bands replicate less often * * */
+USTRUCT()
+struct FHelicopterFrequencyBucket
+{
+	GENERATED_BODY()
+
+	/* Helicopters closer than this to the viewer fall in this bucket */
+	UPROPERTY()
+	float MaxDistance = 0.0f;
+
+	/* Replicate once every this many replication frames */
+	UPROPERTY()
+	int32 ReplicationPeriodFrame = 1;
+};
+
+/* * * Per-connection node deciding which helicopters a viewer gets and how often * * */
+UCLASS()
+class HELICOPTERMOVEMENT_API UReplicationGraphNode_HelicopterPolicy : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	/* Graph that owns the shared helicopter list and the policy settings */
+	UPROPERTY()
+	TObjectPtr<UHelicopterReplicationGraph> Graph;
+
+	/* Connection this node gathers for, used for reporting */
+	TWeakObjectPtr<UNetConnection> NetConnection;
+
+	/* Helicopters handed to the connection on the last gather */
+	int32 LastGatheredCount = 0;
+	int32 LastCulledCount = 0;
+
+private:
+	FActorRepListRefView GatheredHelicopters;
+};
+
+/* * * Replication graph with a helicopter aware relevancy policy * * */
+// Helicopters get an altitude aware cull distance, distance based update frequency buckets per viewer and are always
+// relevant to viewers on the same team as their occupants. Everything else goes through a standard spatial grid.
+// The team rule needs the project's controllers to implement IGenericTeamAgentInterface, without that it never applies.
+// Enabled by setting ReplicationDriverClassName on the net driver in DefaultEngine.ini.
+UCLASS(Transient, Config = Engine)
+class HELICOPTERMOVEMENT_API UHelicopterReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UHelicopterReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/* Cull distance for a helicopter at the given height above the viewer */
+	float GetHelicopterCullDistance(float AltitudeAboveViewer) const;
+
+	/* Replication period for a helicopter at the given distance, zero if it should be culled */
+	int32 GetHelicopterReplicationPeriod(float Distance, float AltitudeAboveViewer) const;
+
+	/* True if the viewer is on the same team as whoever is flying or riding the helicopter, always false unless the viewer's controller implements IGenericTeamAgentInterface */
+	static bool IsOccupiedByViewerTeam(const AHelicopterBasePawn* Helicopter, const AActor* Viewer);
+
+	/* Seated occupants stay relevant wherever their helicopter is, and on their own replicate at their seated net update frequency */
+	void AddSeatedOccupant(AHelicopterBasePawn* Helicopter, AActor* Occupant);
+	/* Puts the occupant back on its class replication period, call after its net update frequency is restored */
+	void RemoveSeatedOccupant(AHelicopterBasePawn* Helicopter, AActor* Occupant);
+
+	/* Writes replication CPU time and per connection bandwidth to the log */
+	void LogReplicationStats() const;
+
+	const FActorRepListRefView& GetHelicopters() const { return Helicopters; }
+
+	/* Size of a spatial grid cell for non helicopter actors */
+	UPROPERTY(Config)
+	float GridCellSize;
+
+	/* Cull distance for a helicopter level with the viewer */
+	UPROPERTY(Config)
+	float HelicopterBaseCullDistance;
+
+	/* Extra cull distance per unit of height the helicopter is above the viewer */
+	UPROPERTY(Config)
+	float HelicopterAltitudeCullScale;
+
+	/* Cull distance is never pushed past this, however high the helicopter is */
+	UPROPERTY(Config)
+	float HelicopterMaxCullDistance;
+
+	/* Sorted nearest first, helicopters beyond the last bucket use its period */
+	UPROPERTY(Config)
+	TArray<FHelicopterFrequencyBucket> FrequencyBuckets;
+
+private:
+	/* Changes an actor's period in its global info and in every connection that already replicates it */
+	void SetActorReplicationPeriod(AActor* Actor, uint32 ReplicationPeriodFrame);
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UReplicationGraphNode_HelicopterPolicy>> HelicopterNodes;
+
+	/* Every replicated helicopter, shared by the per connection policy nodes */
+	FActorRepListRefView Helicopters;
+
+	/* Smoothed cost of ServerReplicateActors */
+	double AverageReplicateMs = 0.0;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HelicopterTelemetrySubsystem.generated.h"
+
+/* Forward Declarations */
+class UHelicopterMoverComponent;
+
+enum class ETelemetry_Record : uint8
+{
+	ETR_State,
+	ETR_Correction,
+	ETR_SweepHit,
+
+	ETR_Max
+};
+
+/* * * One fixed size telemetry record, written to disk exactly as laid out here * * */
+struct FHelicopterTelemetryRecord
+{
+	/* World time the record was taken at */
+	double Time = 0.0;
+
+	/* Handed out once per mover as it begins play and never reused within the process */
+	uint32 HelicopterId = 0;
+
+	ETelemetry_Record Type = ETelemetry_Record::ETR_State;
+
+	/* ENetMode of the world that took the record */
+	uint8 NetMode = 0;
+	uint8 Padding[2] = { 0, 0 };
+
+	FVector3f Position = FVector3f::ZeroVector;
+	FRotator3f Rotation = FRotator3f::ZeroRotator;
+	FVector3f Velocity = FVector3f::ZeroVector;
+	FVector3f Input = FVector3f::ZeroVector;
+	float YawInput = 0.0f;
+
+	/* Position error for corrections, impact normal for sweep hits */
+	FVector3f Detail = FVector3f::ZeroVector;
+};
+
+static_assert(sizeof(FHelicopterTelemetryRecord) == 80, "Telemetry records are read back by size, bump the file version when changing the layout");
+
+/* * * Start of a telemetry file, followed by chunks of records * * */
+struct FHelicopterTelemetryFileHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x31524648; // "HFR1"
+	static constexpr uint16 CurrentVersion = 2;
+
+	uint32 Magic = ExpectedMagic;
+	uint16 Version = CurrentVersion;
+	uint16 RecordSize = sizeof(FHelicopterTelemetryRecord);
+
+	/* UTC ticks of when the recording started */
+	int64 StartUtcTicks = 0;
+};
+
+/* * * Header before every chunk, the records follow it back to back * * */
+struct FHelicopterTelemetryChunkHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x43524648; // "HFRC"
+
+	uint32 Magic = ExpectedMagic;
+	uint32 NumRecords = 0;
+
+	/* Records lost because a ring buffer was full since the previous chunk */
+	uint32 NumDropped = 0;
+	uint32 Reserved = 0;
+};
+
+/* * * Records the flight of every helicopter into a binary telemetry file * * */
+// Records go into per thread lock free ring buffers and a background thread flushes them to disk in chunks, so the
+// cost on the recording threads is one copy per record. Every header and record is a multiple of 16 bytes, which
+// keeps the file easy to memory map. Controlled with heli.Telemetry.Start/Stop, read back with heli.Telemetry.ExportCsv.
+// State records are taken on the server only. Corrections happen where the prediction is, so they only appear in
+// recordings taken on a client or a PIE session that includes one, never in a dedicated server recording.
+UCLASS()
+class HELICOPTERMOVEMENT_API UHelicopterTelemetrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	/* Starts writing to the given file, game thread only */
+	static bool StartRecording(const FString& FilePath);
+
+	/* Flushes and closes the current file, game thread only */
+	static void StopRecording();
+
+	static bool IsRecording();
+
+	/* Next id for FHelicopterTelemetryRecord::HelicopterId, called by each mover as it begins play */
+	static uint32 MakeHelicopterId();
+
+	/* Event hooks for the mover, cheap no-ops while nothing is recording */
+	static void RecordCorrection(const UHelicopterMoverComponent* Mover, const FVector& PositionError);
+	static void RecordSweepHit(const UHelicopterMoverComponent* Mover, const FHitResult& HitResult);
+
+	/* Converts a telemetry file to CSV, one line per record */
+	static bool ExportCsv(const FString& InFilePath, const FString& OutFilePath);
+};